@@ -0,0 +1,230 @@
+#include "Afc.h"
+#include "SensorBase.h"
+
+// Cheap sensors drift with their temperature. For every sensor we keep a running
+// estimate of its frequency offset from the FEI of its frames and tune the receiver
+// to the middle of the offsets, so all known sensors stay inside the RX bandwidth.
+// The receiver crystal drifts too. Because that shifts the FEI of all sensors
+// alike, it is learned as a coefficient per degree of the radio chip temperature.
+
+#define AFC_TEMPERATURE_INTERVAL  300000UL    // read the chip temperature every 5 minutes
+#define AFC_SENSOR_TIMEOUT        600000UL    // ignore sensors not heard for 10 minutes
+#define AFC_DEVIATION             90          // kHz, all data rate profiles
+#define AFC_MARGIN                5           // kHz added to the spread of the sensors
+
+Afc::Afc(RFMxx *rfm) {
+  m_rfm = rfm;
+  m_enabled = false;
+  m_baseFrequency = 868300;
+  m_baseBandwidth = 0;
+  m_baseDataRate = 0;
+  m_temperature = 0;
+  m_temperatureCoefficient = 0;
+  m_lastTemperatureRead = 0;
+  for (byte i = 0; i < AFC_SENSORS; i++) {
+    m_sensors[i].protocol = SensorBase::PROTOCOL_NONE;
+    m_sensors[i].count = 0;
+  }
+}
+
+void Afc::Enable(bool enabled) {
+  if (enabled && !m_enabled) {
+    m_baseFrequency = m_rfm->GetFrequency();
+    m_baseBandwidth = m_rfm->GetBandwidth();
+    m_baseDataRate = m_rfm->GetDataRate();
+    m_lastTemperatureRead = 0;
+  }
+  else if (!enabled && m_enabled) {
+    UpdateBaseBandwidth();
+    m_rfm->SetFrequency(m_baseFrequency);
+    m_rfm->SetBandwidth(m_baseBandwidth);
+    Restart();
+  }
+  m_enabled = enabled;
+}
+
+bool Afc::IsEnabled() {
+  return m_enabled;
+}
+
+void Afc::SetBaseFrequency(unsigned long kHz) {
+  // Keep the learned offsets, they are relative to the base frequency
+  long shift = ((long)kHz - (long)m_baseFrequency) * 1000L;
+  for (byte i = 0; i < AFC_SENSORS; i++) {
+    m_sensors[i].offset -= shift;
+  }
+  m_baseFrequency = kHz;
+  m_rfm->SetFrequency(kHz);
+  if (m_enabled) {
+    Retune();
+  }
+  Restart();
+}
+
+// Frames are handled with the receiver already back in RX when it restarts at once,
+// the new frequency and bandwidth need a restart with a PLL lock to take effect
+void Afc::Restart() {
+  if (m_rfm->IsReceiving()) {
+    m_rfm->RestartReceiver(true);
+  }
+}
+
+Afc::Sensor *Afc::FindSensor(byte protocol, word id) {
+  unsigned long now = millis();
+  Sensor *replace = &m_sensors[0];
+  for (byte i = 0; i < AFC_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == protocol && sensor->id == id) {
+      return sensor;
+    }
+    if (replace->protocol != SensorBase::PROTOCOL_NONE
+      && (sensor->protocol == SensorBase::PROTOCOL_NONE || now - sensor->lastSeen > now - replace->lastSeen)) {
+      replace = sensor;
+    }
+  }
+
+  // Take a free or the least recently seen entry
+  replace->protocol = protocol;
+  replace->id = id;
+  replace->count = 0;
+  return replace;
+}
+
+long Afc::GetCompensatedOffset(Sensor *sensor) {
+  return sensor->offset + (long)m_temperatureCoefficient * (m_temperature - sensor->temperature);
+}
+
+void Afc::Update(byte protocol, word id, long fei) {
+  if (!m_enabled || protocol == SensorBase::PROTOCOL_NONE) {
+    return;
+  }
+
+  // FEI is relative to the current tuning, the table is relative to the base frequency
+  long measured = fei + ((long)m_rfm->GetFrequency() - (long)m_baseFrequency) * 1000L;
+
+  Sensor *sensor = FindSensor(protocol, id);
+  if (sensor->count == 0) {
+    sensor->offset = measured;
+  }
+  else {
+    long predicted = GetCompensatedOffset(sensor);
+    int8_t deltaT = m_temperature - sensor->temperature;
+    if (deltaT >= 2 || deltaT <= -2) {
+      // The receiver drift is common to all sensors, their own drift averages out
+      int coefficient = (measured - sensor->offset) / deltaT;
+      m_temperatureCoefficient += (coefficient - m_temperatureCoefficient) / 8;
+    }
+    sensor->offset = predicted + (measured - predicted) / 4;
+  }
+  sensor->temperature = m_temperature;
+  sensor->lastSeen = millis();
+  if (sensor->count < 255) {
+    sensor->count++;
+  }
+
+  if (Retune()) {
+    Restart();
+  }
+}
+
+// A data rate profile sets its own bandwidth, that is the widest one from then on.
+// Another data rate keeps the bandwidth and the base with it.
+void Afc::UpdateBaseBandwidth() {
+  if (m_rfm->GetDataRate() != m_baseDataRate) {
+    m_baseDataRate = m_rfm->GetDataRate();
+    if (m_rfm->GetProfile() < RFMxx::PROFILE_COUNT) {
+      m_baseBandwidth = m_rfm->GetBandwidth();
+    }
+  }
+}
+
+// Returns true if the frequency or the bandwidth changed
+bool Afc::Retune() {
+  UpdateBaseBandwidth();
+  long minOffset = 0;
+  long maxOffset = 0;
+  bool found = false;
+  for (byte i = 0; i < AFC_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE || sensor->count < 2 || millis() - sensor->lastSeen > AFC_SENSOR_TIMEOUT) {
+      continue;
+    }
+    long offset = GetCompensatedOffset(sensor);
+    if (!found || offset < minOffset) {
+      minOffset = offset;
+    }
+    if (!found || offset > maxOffset) {
+      maxOffset = offset;
+    }
+    found = true;
+  }
+  if (!found) {
+    return false;
+  }
+
+  long centre = (minOffset + maxOffset) / 2;
+  unsigned long target = m_baseFrequency + (centre + (centre >= 0 ? 500 : -500)) / 1000;
+  long step = m_rfm->GetRadioType() == RFMxx::RFM12B ? 5 : 2;
+  long delta = (long)target - (long)m_rfm->GetFrequency();
+  bool changed = false;
+  if (delta >= step || delta <= -step) {
+    m_rfm->SetFrequency(target);
+    changed = true;
+  }
+
+  // Narrow the bandwidth when all sensors are close together. The signal takes the deviation
+  // plus half the bit rate on each side of the centre, the sensors half their spread.
+  word bandwidth = m_rfm->RoundBandwidth(AFC_DEVIATION + m_rfm->GetDataRate() / 2000 + (maxOffset - minOffset) / 2000 + AFC_MARGIN);
+  if (bandwidth > m_baseBandwidth) {
+    bandwidth = m_baseBandwidth;
+  }
+  if (bandwidth != m_rfm->GetBandwidth()) {
+    m_rfm->SetBandwidth(bandwidth);
+    changed = true;
+  }
+  return changed;
+}
+
+void Afc::Handle() {
+  if (!m_enabled || m_rfm->GetRadioType() == RFMxx::RFM12B) {
+    return;
+  }
+  if (m_lastTemperatureRead == 0 || millis() - m_lastTemperatureRead > AFC_TEMPERATURE_INTERVAL) {
+    m_lastTemperatureRead = millis();
+    m_temperature = m_rfm->GetTemperature();
+  }
+}
+
+void Afc::Report() {
+  Serial.print(F("[AFC "));
+  Serial.print(m_enabled ? "on" : "off");
+  Serial.print(F(" Base:"));
+  Serial.print(m_baseFrequency);
+  Serial.print(F(" Tuned:"));
+  Serial.print(m_rfm->GetFrequency());
+  Serial.print(F(" BW:"));
+  Serial.print(m_rfm->GetBandwidth());
+  Serial.print(F(" Temp:"));
+  Serial.print(m_temperature, DEC);
+  Serial.print(F(" Hz/C:"));
+  Serial.print(m_temperatureCoefficient);
+  Serial.println(']');
+
+  for (byte i = 0; i < AFC_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE) {
+      continue;
+    }
+    Serial.print(F("AFC "));
+    Serial.print(SensorBase::GetProtocolName(sensor->protocol));
+    Serial.print(F(" ID:"));
+    Serial.print(sensor->id, DEC);
+    Serial.print(F(" Offset:"));
+    Serial.print(GetCompensatedOffset(sensor));
+    Serial.print(F(" Count:"));
+    Serial.print(sensor->count, DEC);
+    Serial.print(F(" Age:"));
+    Serial.print((millis() - sensor->lastSeen) / 1000);
+    Serial.println();
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef _AFC_h
+#define _AFC_h
+
+#include "Arduino.h"
+#include "RFMxx.h"
+
+#ifdef ESP32
+#define AFC_SENSORS 8
+#else
+#define AFC_SENSORS 4
+#endif
+
+class Afc {
+ private:
+   struct Sensor {
+     byte protocol;
+     word id;
+     long offset;                 // Hz relative to the base frequency at m_temperature
+     int8_t temperature;          // chip temperature when offset was estimated
+     byte count;
+     unsigned long lastSeen;
+   };
+
+   RFMxx *m_rfm;
+   bool m_enabled;
+   unsigned long m_baseFrequency;
+   word m_baseBandwidth;          // of the data rate in m_baseDataRate
+   unsigned long m_baseDataRate;
+   Sensor m_sensors[AFC_SENSORS];
+   int8_t m_temperature;
+   int m_temperatureCoefficient;  // receiver crystal drift in Hz per degree
+   unsigned long m_lastTemperatureRead;
+
+   Sensor *FindSensor(byte protocol, word id);
+   long GetCompensatedOffset(Sensor *sensor);
+   void UpdateBaseBandwidth();
+   bool Retune();
+   void Restart();
+
+ public:
+   Afc(RFMxx *rfm);
+   void Enable(bool enabled);
+   bool IsEnabled();
+   void SetBaseFrequency(unsigned long kHz);
+   void Update(byte protocol, word id, long fei);
+   void Handle();
+   void Report();
+};
+
+#endif
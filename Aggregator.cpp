@@ -0,0 +1,147 @@
+#include "Aggregator.h"
+#include "SensorBase.h"
+
+// Most sensors send every few seconds, but the host stores one value per minute or less.
+// In the aggregation output mode the values of every sensor are collected for a window
+// and only a summary line per sensor is sent at the end of the window:
+//
+//   AGG LaCrosse ID:12 N:15 Temp:21.2,21.4,21.7 Hum:45.0,45.6,46.0
+//
+// N is the number of frames, every value is given as minimum,mean,maximum.
+// A sensor that does not fit into the table any more ends the window of the one heard least
+// recently early.
+
+Aggregator::Sensor Aggregator::m_sensors[AGGREGATE_SENSORS];
+word Aggregator::m_window = 60;
+unsigned long Aggregator::m_windowStart = 0;
+
+// Values are kept as integers in tenths, the power in W is too large for that
+static const byte scales[AGGREGATE_VALUES] = { 10, 10, 10, 1, 10 };
+
+void Aggregator::SetWindow(word seconds) {
+  Flush();
+  m_window = seconds > 0 ? seconds : 1;
+}
+
+word Aggregator::GetWindow() {
+  return m_window;
+}
+
+Aggregator::Sensor *Aggregator::FindSensor(byte protocol, word id) {
+  unsigned long now = millis();
+  Sensor *empty = NULL;
+  Sensor *oldest = NULL;
+  for (byte i = 0; i < AGGREGATE_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->count == 0) {
+      if (empty == NULL) {
+        empty = sensor;
+      }
+    }
+    else if (sensor->protocol == protocol && sensor->id == id) {
+      sensor->lastSeen = now;
+      return sensor;
+    }
+    else if (oldest == NULL || now - sensor->lastSeen > now - oldest->lastSeen) {
+      oldest = sensor;
+    }
+  }
+
+  if (empty == NULL) {
+    empty = oldest;
+    Emit(empty);
+  }
+  empty->protocol = protocol;
+  empty->id = id;
+  empty->lastSeen = now;
+  for (byte s = 0; s < AGGREGATE_SLOTS; s++) {
+    empty->slots[s].value = SensorBase::VALUE_COUNT;
+  }
+  return empty;
+}
+
+void Aggregator::Add(byte protocol, word id, word valueMask, float *values) {
+  Sensor *sensor = FindSensor(protocol, id);
+  for (byte value = 0; value < AGGREGATE_VALUES; value++) {
+    if (!(valueMask & (1 << value))) {
+      continue;
+    }
+
+    Slot *slot = NULL;
+    for (byte s = 0; s < AGGREGATE_SLOTS; s++) {
+      if (sensor->slots[s].value == value) {
+        slot = &sensor->slots[s];
+        break;
+      }
+      if (sensor->slots[s].value == SensorBase::VALUE_COUNT) {
+        slot = &sensor->slots[s];
+        slot->value = value;
+        slot->min = 32767;
+        slot->max = -32768;
+        slot->sum = 0;
+        slot->count = 0;
+        break;
+      }
+    }
+    if (slot == NULL) {
+      continue;
+    }
+
+    float scaled = values[value] * scales[value];
+    int v = (int)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    if (v < slot->min) {
+      slot->min = v;
+    }
+    if (v > slot->max) {
+      slot->max = v;
+    }
+    slot->sum += v;
+    slot->count++;
+  }
+  sensor->count++;
+}
+
+void Aggregator::Emit(Sensor *sensor) {
+  if (sensor->count == 0) {
+    return;
+  }
+
+  Serial.print(F("AGG "));
+  Serial.print(SensorBase::GetProtocolName(sensor->protocol));
+  Serial.print(F(" ID:"));
+  Serial.print(sensor->id, DEC);
+  Serial.print(F(" N:"));
+  Serial.print(sensor->count, DEC);
+  for (byte s = 0; s < AGGREGATE_SLOTS; s++) {
+    Slot *slot = &sensor->slots[s];
+    if (slot->value == SensorBase::VALUE_COUNT) {
+      break;
+    }
+    float scale = scales[slot->value];
+    Serial.print(' ');
+    Serial.print(SensorBase::GetValueName(slot->value));
+    Serial.print(':');
+    Serial.print(slot->min / scale, 1);
+    Serial.print(',');
+    Serial.print(slot->sum / scale / slot->count, 1);
+    Serial.print(',');
+    Serial.print(slot->max / scale, 1);
+  }
+  SensorBase::DisplayTime();
+  Serial.println();
+
+  sensor->count = 0;
+}
+
+void Aggregator::Flush() {
+  for (byte i = 0; i < AGGREGATE_SENSORS; i++) {
+    Emit(&m_sensors[i]);
+  }
+  m_windowStart = millis();
+}
+
+void Aggregator::Handle() {
+  if (millis() - m_windowStart >= m_window * 1000UL) {
+    Flush();
+  }
+}
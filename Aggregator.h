@@ -0,0 +1,49 @@
+#ifndef _AGGREGATOR_h
+#define _AGGREGATOR_h
+
+#include "Arduino.h"
+
+// The ATmega328 lacks the RAM for the summary output, define USE_AGGREGATOR to build it in anyway
+#ifdef ESP32
+#define USE_AGGREGATOR
+#define AGGREGATE_SENSORS 24
+#else
+#define AGGREGATE_SENSORS 4
+#endif
+#define AGGREGATE_SLOTS   3                         // no sensor reports more values
+#define AGGREGATE_VALUES  5                         // temperature, humidity, wind, power, level
+
+class Aggregator {
+private:
+  struct Slot {
+    byte value;                   // SensorBase::Value, VALUE_COUNT if unused
+    int min;                      // scaled, see scales[]
+    int max;
+    long sum;
+    word count;                   // WS1600 does not send every value in every frame
+  };
+
+  struct Sensor {
+    byte protocol;
+    word id;
+    word count;
+    unsigned long lastSeen;       // millis() of the last frame, a full table evicts the least recent
+    Slot slots[AGGREGATE_SLOTS];
+  };
+
+  static Sensor m_sensors[AGGREGATE_SENSORS];
+  static word m_window;
+  static unsigned long m_windowStart;
+
+  static Sensor *FindSensor(byte protocol, word id);
+  static void Emit(Sensor *sensor);
+
+public:
+  static void SetWindow(word seconds);
+  static word GetWindow();
+  static void Add(byte protocol, word id, word valueMask, float *values);
+  static void Flush();
+  static void Handle();
+};
+
+#endif
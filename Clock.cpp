@@ -0,0 +1,166 @@
+#include "Clock.h"
+
+// Wall clock time from the DCF77 time frames of WH1080 stations.
+// Between the frames the time runs on millis(). Its error against DCF is measured
+// over at least CLOCK_MIN_SYNC_SPAN seconds and used as the length of a second.
+// The output needs the time as text for every line, so the text is kept up to date
+// with each tick instead of being formatted from seconds for every line.
+
+bool Clock::m_valid = false;
+byte Clock::m_year = 0;
+byte Clock::m_month = 1;
+byte Clock::m_day = 1;
+byte Clock::m_hour = 0;
+byte Clock::m_minute = 0;
+byte Clock::m_second = 0;
+char Clock::m_text[20] = "2000-01-01T00:00:00";
+unsigned long Clock::m_lastTick = 0;
+word Clock::m_fraction = 0;
+unsigned long Clock::m_millisPer1000s = CLOCK_NOMINAL;
+unsigned long Clock::m_syncMillis = 0;
+unsigned long Clock::m_syncSeconds = 0;
+unsigned long Clock::m_syncs = 0;
+long Clock::m_lastError = 0;
+
+byte Clock::DaysInMonth(byte year, byte month) {
+  if (month == 2) {
+    return (year & 3) == 0 ? 29 : 28;
+  }
+  return (month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31;
+}
+
+// Seconds since 2000-01-01, only needed when a time frame comes in
+unsigned long Clock::ToSeconds(byte year, byte month, byte day, byte hour, byte minute, byte second) {
+  unsigned long days = year * 365UL + (year + 3) / 4;
+  for (byte m = 1; m < month; m++) {
+    days += DaysInMonth(year, m);
+  }
+  days += day - 1;
+  return ((days * 24 + hour) * 60 + minute) * 60 + second;
+}
+
+void Clock::SetDigits(byte position, byte value) {
+  m_text[position] = '0' + value / 10;
+  m_text[position + 1] = '0' + value % 10;
+}
+
+void Clock::UpdateText() {
+  SetDigits(2, m_year);
+  SetDigits(5, m_month);
+  SetDigits(8, m_day);
+  SetDigits(11, m_hour);
+  SetDigits(14, m_minute);
+  SetDigits(17, m_second);
+}
+
+void Clock::Set(byte year, byte month, byte day, byte hour, byte minute, byte second) {
+  if (year > 99 || month < 1 || month > 12 || day < 1 || day > DaysInMonth(year, month)
+    || hour > 23 || minute > 59 || second > 59) {
+    return;
+  }
+
+  unsigned long now = millis();
+  unsigned long seconds = ToSeconds(year, month, day, hour, minute, second);
+  if (m_valid) {
+    long offset = (long)(ToSeconds(m_year, m_month, m_day, m_hour, m_minute, m_second) - seconds);
+    m_lastError = offset * 1000 + (long)(now - m_lastTick);
+  }
+
+  if (!m_valid || seconds < m_syncSeconds) {
+    m_syncMillis = now;
+    m_syncSeconds = seconds;
+  }
+  else if (seconds - m_syncSeconds >= CLOCK_MIN_SYNC_SPAN) {
+    // millis() per 1000 seconds since the last estimate, averaged with the ones before
+    unsigned long measured = (unsigned long)((float)(now - m_syncMillis) * 1000.0 / (seconds - m_syncSeconds));
+    if (measured > CLOCK_NOMINAL - CLOCK_MAX_DRIFT && measured < CLOCK_NOMINAL + CLOCK_MAX_DRIFT) {
+      m_millisPer1000s = (m_millisPer1000s * 3 + measured) / 4;
+    }
+    m_syncMillis = now;
+    m_syncSeconds = seconds;
+  }
+
+  m_year = year;
+  m_month = month;
+  m_day = day;
+  m_hour = hour;
+  m_minute = minute;
+  m_second = second;
+  UpdateText();
+  m_lastTick = now;
+  m_fraction = 0;
+  m_valid = true;
+  m_syncs++;
+}
+
+void Clock::Tick() {
+  if (++m_second < 60) {
+    SetDigits(17, m_second);
+    return;
+  }
+  m_second = 0;
+  SetDigits(17, m_second);
+  if (++m_minute < 60) {
+    SetDigits(14, m_minute);
+    return;
+  }
+  m_minute = 0;
+  SetDigits(14, m_minute);
+  if (++m_hour < 24) {
+    SetDigits(11, m_hour);
+    return;
+  }
+  m_hour = 0;
+  SetDigits(11, m_hour);
+  if (++m_day > DaysInMonth(m_year, m_month)) {
+    m_day = 1;
+    if (++m_month > 12) {
+      m_month = 1;
+      m_year = (m_year + 1) % 100;
+    }
+  }
+  // Once a day, the date is cheap enough to write as a whole
+  UpdateText();
+}
+
+void Clock::Handle() {
+  if (!m_valid) {
+    return;
+  }
+  for (;;) {
+    unsigned long step = m_fraction + m_millisPer1000s;
+    unsigned long interval = step / 1000;
+    if (millis() - m_lastTick < interval) {
+      break;
+    }
+    m_lastTick += interval;
+    m_fraction = step % 1000;
+    Tick();
+  }
+}
+
+bool Clock::IsValid() {
+  return m_valid;
+}
+
+void Clock::Print() {
+  Serial.print(m_text);
+}
+
+void Clock::Report() {
+  Serial.print(F("[Clock Time:"));
+  if (m_valid) {
+    Print();
+  }
+  else {
+    Serial.print('-');
+  }
+  Serial.print(F(" Syncs:"));
+  Serial.print(m_syncs);
+  // ms per 1000 s above nominal are ppm
+  Serial.print(F(" Drift:"));
+  Serial.print((long)(m_millisPer1000s - CLOCK_NOMINAL));
+  Serial.print(F(" Error:"));
+  Serial.print(m_lastError);
+  Serial.println(']');
+}
@@ -0,0 +1,42 @@
+#ifndef _CLOCK_h
+#define _CLOCK_h
+
+#include "Arduino.h"
+
+#define CLOCK_NOMINAL          1000000UL           // millis() per 1000 seconds
+#define CLOCK_MAX_DRIFT        10000UL             // reject estimates off by more than 1 %
+#define CLOCK_MIN_SYNC_SPAN    3600UL              // seconds between syncs for a drift estimate
+
+class Clock {
+public:
+  static void Set(byte year, byte month, byte day, byte hour, byte minute, byte second);
+  static void Handle();
+  static bool IsValid();
+  static void Print();
+  static void Report();
+
+private:
+  static bool m_valid;
+  static byte m_year;           // 2000 based
+  static byte m_month;
+  static byte m_day;
+  static byte m_hour;
+  static byte m_minute;
+  static byte m_second;
+  static char m_text[20];       // YYYY-MM-DDTHH:MM:SS, updated with every tick
+  static unsigned long m_lastTick;
+  static word m_fraction;       // thousandths of a millisecond behind m_lastTick
+  static unsigned long m_millisPer1000s;
+  static unsigned long m_syncMillis;
+  static unsigned long m_syncSeconds;
+  static unsigned long m_syncs;
+  static long m_lastError;      // ms the clock was off at the last sync
+
+  static void Tick();
+  static byte DaysInMonth(byte year, byte month);
+  static unsigned long ToSeconds(byte year, byte month, byte day, byte hour, byte minute, byte second);
+  static void SetDigits(byte position, byte value);
+  static void UpdateText();
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "Config.h"
+#include "SensorBase.h"
+#include <EEPROM.h>
+
+// The settings FHEM would otherwise send after every power cycle. A block holds a version,
+// a sequence number, the settings and a CRC-8 over all of it. Every save goes to the next
+// of CONFIG_SLOTS slots, so the cells wear evenly, and a save without a change writes
+// nothing. At boot the valid slot with the highest sequence number is taken.
+// The sensor filter lists keep their own block at FILTER_EEPROM_ADDRESS.
+
+bool Config::m_valid = false;
+byte Config::m_slot = CONFIG_SLOTS - 1;
+byte Config::m_sequence = 0;
+word Config::m_writes = 0;
+
+int Config::GetAddress(byte slot) {
+  return CONFIG_EEPROM_ADDRESS + slot * SLOT_SIZE;
+}
+
+byte Config::CalculateCRC(Header &header, Settings &settings) {
+  byte crc = 0;
+  byte *bytes = (byte *)&header;
+  for (byte i = 0; i < sizeof(Header); i++) {
+    crc = SensorBase::UpdateCRC(crc, bytes[i]);
+  }
+  bytes = (byte *)&settings;
+  for (byte i = 0; i < sizeof(Settings); i++) {
+    crc = SensorBase::UpdateCRC(crc, bytes[i]);
+  }
+  return crc;
+}
+
+bool Config::ReadSlot(byte slot, Header &header, Settings &settings) {
+  int address = GetAddress(slot);
+  EEPROM.get(address, header);
+  if (header.magic != CONFIG_MAGIC || header.version != CONFIG_VERSION) {
+    return false;
+  }
+  EEPROM.get(address + sizeof(Header), settings);
+  return EEPROM.read(address + sizeof(Header) + sizeof(Settings)) == CalculateCRC(header, settings);
+}
+
+bool Config::Load(Settings &settings) {
+#ifdef ESP32
+  EEPROM.begin(CONFIG_EEPROM_SIZE);
+#endif
+  m_valid = false;
+  for (byte slot = 0; slot < CONFIG_SLOTS; slot++) {
+    Header header;
+    Settings candidate;
+    if (!ReadSlot(slot, header, candidate)) {
+      continue;
+    }
+    // Sequence numbers wrap, newer is less than half the range ahead
+    if (!m_valid || (byte)(header.sequence - m_sequence) < 128) {
+      m_valid = true;
+      m_slot = slot;
+      m_sequence = header.sequence;
+      settings = candidate;
+    }
+  }
+  return m_valid;
+}
+
+// Returns false when the stored settings are the same and nothing was written
+bool Config::Save(Settings &settings) {
+  if (m_valid) {
+    Header header;
+    Settings stored;
+    if (ReadSlot(m_slot, header, stored) && memcmp(&stored, &settings, sizeof(Settings)) == 0) {
+      return false;
+    }
+  }
+
+  byte slot = (m_slot + 1) % CONFIG_SLOTS;
+  Header header = { CONFIG_MAGIC, CONFIG_VERSION, (byte)(m_sequence + 1) };
+  int address = GetAddress(slot);
+  // The CRC only fits once the whole block is written, an interrupted save leaves the old slot current
+  EEPROM.put(address, header);
+  EEPROM.put(address + sizeof(Header), settings);
+  EEPROM.write(address + sizeof(Header) + sizeof(Settings), CalculateCRC(header, settings));
+#ifdef ESP32
+  EEPROM.commit();
+#endif
+  m_valid = true;
+  m_slot = slot;
+  m_sequence = header.sequence;
+  m_writes++;
+  return true;
+}
+
+void Config::Erase() {
+  for (byte slot = 0; slot < CONFIG_SLOTS; slot++) {
+    EEPROM.write(GetAddress(slot), 0xFF);
+  }
+#ifdef ESP32
+  EEPROM.commit();
+#endif
+  m_valid = false;
+}
+
+void Config::Report() {
+  Serial.print(F("[Config "));
+  Serial.print(m_valid ? "stored" : "compiled");
+  Serial.print(F(" Version:"));
+  Serial.print(CONFIG_VERSION);
+  Serial.print(F(" Slot:"));
+  Serial.print(m_slot);
+  Serial.print(F(" Sequence:"));
+  Serial.print(m_sequence);
+  Serial.print(F(" Writes:"));
+  Serial.print(m_writes);
+  Serial.println(']');
+}
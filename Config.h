@@ -0,0 +1,59 @@
+#ifndef _CONFIG_h
+#define _CONFIG_h
+
+#include "Arduino.h"
+
+#define CONFIG_EEPROM_ADDRESS  128                  // behind the sensor filter lists
+#define CONFIG_EEPROM_SIZE     512                  // EEPROM emulation size on ESP32, filters and config
+#define CONFIG_SLOTS           4                    // saves rotate over the slots
+#define CONFIG_VERSION         1                    // increment when Settings changes
+#define CONFIG_MAGIC           0xC5
+
+class Config {
+public:
+  enum Flags {
+    FLAG_RELAY = 1,
+    FLAG_AFC = 2,
+    FLAG_CORRECTION = 4,
+    FLAG_TRANSMIT = 8
+  };
+
+  struct Settings {
+    unsigned long dataRate;
+    unsigned long frequency;          // kHz
+    word toggleInterval;              // seconds between the data rates, 0 = no toggle
+    byte receiveMode;
+    byte outputMode;
+    byte optionalFields;
+    word aggregateWindow;             // seconds
+    byte flags;
+    byte transmitId;
+    word transmitInterval;            // ms
+    unsigned long transmitDataRate;
+  };
+
+  static bool Load(Settings &settings);
+  static bool Save(Settings &settings);
+  static void Erase();
+  static void Report();
+
+private:
+  struct Header {
+    byte magic;
+    byte version;
+    byte sequence;                    // the valid slot with the highest sequence is the current one
+  };
+
+  static const byte SLOT_SIZE = sizeof(Header) + sizeof(Settings) + 1;
+
+  static bool m_valid;
+  static byte m_slot;
+  static byte m_sequence;
+  static word m_writes;
+
+  static int GetAddress(byte slot);
+  static byte CalculateCRC(Header &header, Settings &settings);
+  static bool ReadSlot(byte slot, Header &header, Settings &settings);
+};
+
+#endif
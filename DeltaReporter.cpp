@@ -0,0 +1,162 @@
+#include "DeltaReporter.h"
+
+// Consecutive frames of a sensor mostly carry the same values. In the delta output mode
+// a line lists only the values that moved out of their deadband since they were last sent,
+// a frame without such a change gives no line at all. The first frame of a sensor and
+// every snapshot interval give a line with all values, so the host can resynchronize:
+//
+//   SNP WH1080 ID:177 Temp:12.3 Hum:81 Wind:1.0 Gust:2.4 Rain:212.4 Dir:225.0
+//   DLT WH1080 ID:177 Temp:12.4
+//
+// <SNP|DLT> <protocol> ID:<id> followed by <name>:<value> pairs separated by a space.
+
+DeltaReporter::Sensor DeltaReporter::m_sensors[DELTA_SENSORS];
+byte DeltaReporter::m_snapshotMinutes = 10;
+
+// Deadbands in tenths of the unit, a change must be at least this large to be reported
+word DeltaReporter::m_deadbands[SensorBase::VALUE_COUNT] = {
+  1,    // Temp 0.1 C
+  10,   // Hum 1 %
+  1,    // Wind 0.1 m/s
+  10,   // Power 1 W
+  1,    // Level 0.1
+  1,    // Gust 0.1 m/s
+  1,    // Rain 0.1 mm
+  1,    // Dir every step
+  10,   // Volt 1 V
+  10,   // Curr 1 mA
+  1,    // Energy 0.1 kWh
+  1     // WeakBatt every change
+};
+
+static const byte decimals[SensorBase::VALUE_COUNT] = { 1, 0, 1, 0, 1, 1, 1, 1, 1, 0, 2, 0 };
+
+void DeltaReporter::SetDeadband(byte value, word tenths) {
+  if (value < SensorBase::VALUE_COUNT) {
+    m_deadbands[value] = tenths;
+  }
+}
+
+void DeltaReporter::SetSnapshotMinutes(byte minutes) {
+  m_snapshotMinutes = minutes;
+}
+
+DeltaReporter::Sensor *DeltaReporter::FindSensor(byte protocol, word id, bool &isNew) {
+  unsigned long now = millis();
+  Sensor *empty = NULL;
+  Sensor *oldest = NULL;
+  for (byte i = 0; i < DELTA_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (!sensor->used) {
+      if (empty == NULL) {
+        empty = sensor;
+      }
+    }
+    else if (sensor->protocol == protocol && sensor->id == id) {
+      sensor->lastSeen = now;
+      isNew = false;
+      return sensor;
+    }
+    else if (oldest == NULL || now - sensor->lastSeen > now - oldest->lastSeen) {
+      oldest = sensor;
+    }
+  }
+
+  // Table full, the sensor heard least recently is evicted and gets a snapshot with its next frame
+  if (empty == NULL) {
+    empty = oldest;
+  }
+  empty->protocol = protocol;
+  empty->id = id;
+  empty->lastSeen = now;
+  empty->used = true;
+  for (byte s = 0; s < DELTA_SLOTS; s++) {
+    empty->slots[s].value = SensorBase::VALUE_COUNT;
+  }
+  isNew = true;
+  return empty;
+}
+
+DeltaReporter::Slot *DeltaReporter::FindSlot(Sensor *sensor, byte value, bool &isNew) {
+  for (byte s = 0; s < DELTA_SLOTS; s++) {
+    Slot *slot = &sensor->slots[s];
+    if (slot->value == value) {
+      isNew = false;
+      return slot;
+    }
+    if (slot->value == SensorBase::VALUE_COUNT) {
+      slot->value = value;
+      isNew = true;
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+bool DeltaReporter::IsOutsideDeadband(byte value, float reported, float v) {
+  if (v == reported) {
+    return false;
+  }
+  float difference = v > reported ? v - reported : reported - v;
+  return difference * 10 + 0.001 >= m_deadbands[value];
+}
+
+void DeltaReporter::PrintValue(byte value, float v) {
+  Serial.print(' ');
+  Serial.print(SensorBase::GetValueName(value));
+  Serial.print(':');
+  Serial.print(v, decimals[value]);
+}
+
+void DeltaReporter::Add(byte protocol, word id, word valueMask, float *values) {
+  bool isNew;
+  Sensor *sensor = FindSensor(protocol, id, isNew);
+  bool snapshot = isNew
+    || (m_snapshotMinutes > 0 && millis() - sensor->lastSnapshot >= m_snapshotMinutes * 60000UL);
+  if (snapshot) {
+    sensor->lastSnapshot = millis();
+  }
+
+  bool started = false;
+  for (byte value = 0; value < SensorBase::VALUE_COUNT; value++) {
+    if (!(valueMask & ((word)1 << value))) {
+      continue;
+    }
+    bool isNewSlot;
+    Slot *slot = FindSlot(sensor, value, isNewSlot);
+    if (slot == NULL) {
+      continue;
+    }
+    if (!snapshot && !isNewSlot && !IsOutsideDeadband(value, slot->reported, values[value])) {
+      continue;
+    }
+    slot->reported = values[value];
+
+    if (!started) {
+      Serial.print(snapshot ? F("SNP ") : F("DLT "));
+      Serial.print(SensorBase::GetProtocolName(protocol));
+      Serial.print(F(" ID:"));
+      Serial.print(id, DEC);
+      started = true;
+    }
+    PrintValue(value, values[value]);
+  }
+
+  if (started) {
+    SensorBase::DisplayTime();
+    Serial.println();
+  }
+}
+
+void DeltaReporter::Report() {
+  Serial.print(F("[Deadband"));
+  for (byte value = 0; value < SensorBase::VALUE_COUNT; value++) {
+    Serial.print(' ');
+    Serial.print(SensorBase::GetValueName(value));
+    Serial.print(':');
+    Serial.print(m_deadbands[value] / 10.0, 1);
+  }
+  Serial.print(F(" Snapshot:"));
+  Serial.print(m_snapshotMinutes, DEC);
+  Serial.println(']');
+}
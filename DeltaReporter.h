@@ -0,0 +1,48 @@
+#ifndef _DELTAREPORTER_h
+#define _DELTAREPORTER_h
+
+#include "Arduino.h"
+#include "SensorBase.h"
+
+// The ATmega328 lacks the RAM for the delta output, define USE_DELTA_REPORTER to build it in anyway
+#ifdef ESP32
+#define USE_DELTA_REPORTER
+#define DELTA_SENSORS 24
+#else
+#define DELTA_SENSORS 4
+#endif
+#define DELTA_SLOTS   6                             // WH1080 and WS1600 report the most values
+
+class DeltaReporter {
+private:
+  struct Slot {
+    byte value;                   // SensorBase::Value, VALUE_COUNT if unused
+    float reported;               // last value sent to the host
+  };
+
+  struct Sensor {
+    byte protocol;
+    word id;
+    bool used;
+    unsigned long lastSeen;       // millis() of the last frame, a full table evicts the least recent
+    unsigned long lastSnapshot;
+    Slot slots[DELTA_SLOTS];
+  };
+
+  static Sensor m_sensors[DELTA_SENSORS];
+  static word m_deadbands[SensorBase::VALUE_COUNT];
+  static byte m_snapshotMinutes;
+
+  static Sensor *FindSensor(byte protocol, word id, bool &isNew);
+  static Slot *FindSlot(Sensor *sensor, byte value, bool &isNew);
+  static bool IsOutsideDeadband(byte value, float reported, float v);
+  static void PrintValue(byte value, float v);
+
+public:
+  static void SetDeadband(byte value, word tenths);
+  static void SetSnapshotMinutes(byte minutes);
+  static void Add(byte protocol, word id, word valueMask, float *values);
+  static void Report();
+};
+
+#endif
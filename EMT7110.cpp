@@ -1,4 +1,5 @@
 #include "EMT7110.h"
+#include "SensorFilter.h"
 
 // Data rate: 9.579 kbit/s
 
@@ -62,56 +63,58 @@ bool EMT7110::DisplayFrame(byte *data, struct EMT7110::Frame &frame, bool fOnlyI
   Serial.print(div);
 
   // Show the raw data bytes
-  Serial.print("EMT7110 [");
+  Serial.print(F("EMT7110 ["));
   for (int i = 0; i < FRAME_LENGTH; i++) {
     Serial.print(data[i], HEX);
-    Serial.print(" ");
+    Serial.print(F(" "));
   }
-  Serial.print("]");
+  Serial.print(F("]"));
 
   // Check CRC
   if (!frame.IsValid) {
-    Serial.print(" CRC:WRONG");
+    Serial.print(F(" CRC:WRONG"));
   }
   else {
-    Serial.print(" CRC:OK");
+    Serial.print(F(" CRC:OK"));
   }
+  DisplayOptionalFields();
+
   // Start
-  Serial.print(" S:");
+  Serial.print(F(" S:"));
   Serial.print(frame.Header1, HEX);
-  Serial.print(" ");
+  Serial.print(F(" "));
   Serial.print(frame.Header2, HEX);
 
   // ID
-  Serial.print(" ID:");
+  Serial.print(F(" ID:"));
   Serial.print(frame.ID, HEX);
 
   // Voltage
-  Serial.print(" V:");
+  Serial.print(F(" V:"));
   Serial.print(frame.Voltage);
 
   // Current
-  Serial.print(" mA:");
+  Serial.print(F(" mA:"));
   Serial.print(frame.Current);
 
   // Power
-  Serial.print(" W:");
+  Serial.print(F(" W:"));
   Serial.print(frame.Power);
 
   // AccumulatedPower
-  Serial.print(" kWh:");
+  Serial.print(F(" kWh:"));
   Serial.print(frame.AccumulatedPower);
 
   // Connected
-  Serial.print(" Con.:");
+  Serial.print(F(" Con.:"));
   Serial.print(frame.ConsumersConnected);
 
   // Pairing
-  Serial.print(" Pair:");
+  Serial.print(F(" Pair:"));
   Serial.print(frame.PairingFlag);
 
   // CRC
-  Serial.print(" CRC:");
+  Serial.print(F(" CRC:"));
   Serial.print(frame.CRC);
 
   Serial.println();
@@ -203,11 +206,24 @@ bool EMT7110::TryHandleData(byte *data, bool fFhemDisplay) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
+      if (SensorFilter::IsFiltered(PROTOCOL_EMT7110, frame.ID)) {
+        return true;
+      }
+      SetLastSensor(PROTOCOL_EMT7110, frame.ID);
+      SetValue(VALUE_POWER, frame.Power);
+      SetValue(VALUE_VOLTAGE, frame.Voltage);
+      SetValue(VALUE_CURRENT, frame.Current);
+      SetValue(VALUE_ENERGY, frame.AccumulatedPower);
+      if (ForwardValues()) {
+        return true;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
           return fhemString.length() > 0;
   	     }
@@ -0,0 +1,131 @@
+#include "FrameDetector.h"
+#include "SensorBase.h"
+#include "LaCrosse.h"
+#include "LevelSenderLib.h"
+#include "EMT7110.h"
+#include "WT440XH.h"
+#include "TX38IT.h"
+#include "WH1080.h"
+#include "WS1600.h"
+
+// The candidate frame lengths for the first bytes of a frame
+byte FrameDetector::GetCandidates(byte *data, byte length, byte *lengths) {
+  byte count = 0;
+  if (length == 0) {
+    return 0;
+  }
+
+  switch (data[0] >> 4) {
+  case 0x9: // LaCrosse
+    lengths[count++] = LaCrosse::FRAME_LENGTH;
+    break;
+  case 0xB: // LevelSender, WS4000/WH1080 time
+    lengths[count++] = LevelSenderLib::FRAME_LENGTH;
+    lengths[count++] = LEN_WS4000;
+    break;
+  case 0x5: // WT440XH, WS3000 weather
+    if (data[0] == 0x51) {
+      lengths[count++] = WT440XH::FRAME_LENGTH;
+    }
+    lengths[count++] = LEN_WS3000;
+    break;
+  case 0x6: // WS3000 time
+    lengths[count++] = LEN_WS3000;
+    break;
+  case 0xA: // WS4000/WH1080 weather, WS1600 with a variable number of quartets
+    if (length >= 2 && (data[1] & 0x0F) <= 5) {
+      lengths[count++] = (data[1] & 0x0F) * 2 + 2 + 1;
+    }
+    lengths[count++] = LEN_WS4000;
+    break;
+  default:
+    if (data[0] == 0x25) {
+      lengths[count++] = EMT7110::FRAME_LENGTH;
+    }
+    else if ((data[0] & 0xC0) == 0xC0) {
+      lengths[count++] = TX38IT::FRAME_LENGTH;
+    }
+    break;
+  }
+  return count;
+}
+
+// crc is the CRC-8 over the length bytes, which is 0 for a valid CRC-8 frame
+bool FrameDetector::IsValid(byte *data, byte length, byte crc) {
+  if (data[0] == 0x25 && length == EMT7110::FRAME_LENGTH) {
+    return EMT7110::CrcIsValid(data);
+  }
+  if (data[0] == 0x51 && length == WT440XH::FRAME_LENGTH) {
+    return WT440XH::CrcIsValid(data);
+  }
+  if ((data[0] & 0xC0) == 0xC0 && length == TX38IT::FRAME_LENGTH) {
+    return TX38IT::CalculateCRC(data) == (((data[2] & 0x0F) << 4) | (data[3] >> 4));
+  }
+  return crc == 0;
+}
+
+// True if the bytes received so far form a complete frame of a candidate protocol
+bool FrameDetector::IsComplete(byte *data, byte length, byte crc) {
+  byte lengths[MAX_CANDIDATES];
+  byte count = GetCandidates(data, length, lengths);
+  for (byte i = 0; i < count; i++) {
+    if (lengths[i] == length && IsValid(data, length, crc)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Number of bytes after which no candidate protocol can complete anymore
+byte FrameDetector::GetMaxLength(byte *data, byte length) {
+  byte lengths[MAX_CANDIDATES];
+  byte count = GetCandidates(data, length, lengths);
+  byte maxLength = count > 0 ? 0 : UNKNOWN_MAX_LENGTH;
+  for (byte i = 0; i < count; i++) {
+    if (lengths[i] > maxLength) {
+      maxLength = lengths[i];
+    }
+  }
+  // WS1600 tells its length in the second byte
+  if (length < 2 && (data[0] >> 4) == 0xA) {
+    maxLength = WS1600::FRAME_LENGTH;
+  }
+  return maxLength;
+}
+
+// Length of a valid frame at the start of data, 0 if there is none
+byte FrameDetector::FindFrame(byte *data, byte size) {
+  byte lengths[MAX_CANDIDATES];
+  byte count = GetCandidates(data, size, lengths);
+  for (byte i = 0; i < count; i++) {
+    if (lengths[i] <= size && IsValid(data, lengths[i], SensorBase::CalculateCRC(data, lengths[i]))) {
+      return lengths[i];
+    }
+  }
+  return 0;
+}
+
+// A second transmission in the same payload starts with its own preamble and sync word,
+// at any bit position. Returns the bit position behind the sync word, 0 if there is none.
+word FrameDetector::FindSync(byte *data, byte size, word startBit) {
+  word window = 0;
+  for (word bit = startBit; bit < size * 8; bit++) {
+    window = (window << 1) | ((data[bit >> 3] >> (7 - (bit & 7))) & 1);
+    if (bit - startBit >= 15 && window == 0x2DD4) {
+      return bit + 1;
+    }
+  }
+  return 0;
+}
+
+// Copy length bytes starting at a bit position, data must hold length whole bytes behind it
+void FrameDetector::ExtractBits(byte *data, word bit, byte *frame, byte length) {
+  byte shift = bit & 7;
+  word index = bit >> 3;
+  for (byte i = 0; i < length; i++) {
+    frame[i] = data[index + i] << shift;
+    if (shift) {
+      frame[i] |= data[index + i + 1] >> (8 - shift);
+    }
+  }
+}
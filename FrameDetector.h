@@ -0,0 +1,23 @@
+#ifndef _FRAMEDETECTOR_h
+#define _FRAMEDETECTOR_h
+
+#include "Arduino.h"
+
+// Knows the length and the check of every protocol, so frames can be found
+// in a byte stream without decoding them
+class FrameDetector {
+ private:
+   static byte GetCandidates(byte *data, byte length, byte *lengths);
+   static bool IsValid(byte *data, byte length, byte crc);
+
+ public:
+   static const byte MAX_CANDIDATES = 2;
+   static const byte UNKNOWN_MAX_LENGTH = 16;
+   static bool IsComplete(byte *data, byte length, byte crc);
+   static byte GetMaxLength(byte *data, byte length);
+   static byte FindFrame(byte *data, byte size);
+   static word FindSync(byte *data, byte size, word startBit);
+   static void ExtractBits(byte *data, word bit, byte *frame, byte length);
+};
+
+#endif
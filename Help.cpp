@@ -5,16 +5,34 @@ const char helpText[] PROGMEM =
 "\n"
 "Available commands:" "\n"
 "  <n>a                     - activity LED (0=off, 1=on)" "\n"
+"  <n>b                     - correct single bit errors of CRC-8 frames (0=off, 1=on)" "\n"
 "  <t10>,<t1>,<t0>,<hum>c   - set temperature and humidity for transmit" "\n"
 "  <n>d                     - DEBUG mode (0=suppress TX and bad packets)" "\n"
+"  <n>e                     - AFC (0=off, 1=on, 2=report offset table)" "\n"
 "  <nnnnnn>f                - frequency (5 kHz steps e.g. 868315)" "\n"
+"  <n>g                     - aggregation window in seconds (default 60)" "\n"
+"  <n>h                     - frequency scan (0=stop, 1=863 to 870 MHz, 2=report) with RSSI spectrum, peaks and sensor centre frequencies" "\n"
+"  <w>,<nnnnnn>h            - frequency scan of w times 100 kHz around nnnnnn kHz" "\n"
 "  <id>,<int>,<nbt>,<dr>i   - set the parameters for the transmit loop" "\n"
-"  <n>r                     - data rate (0=17.241 kbps, 1=9.579 kbps)" "\n"
+"  <v>,<n>j                 - deadband of value v for the delta output in tenths (0=Temp, 1=Hum, 2=Wind, 3=Power, 4=Level, 5=Gust, 6=Rain, 7=Dir, 8=Volt, 9=Curr, 10=Energy, 11=WeakBatt)" "\n"
+"  <n>k                     - minutes between full snapshots in the delta output (0=only the first)" "\n"
+"  <n>l                     - RFM69 listen mode (0=off, 1=on with the timing of the data rate profile, 2=report)" "\n"
+"  <idle>,<rx>,<rssi>l      - listen mode with idle and RX phase in 64 us units (0=profile) and wake up level in -dBm" "\n"
+"  <n>m                     - receive mode (0=fixed 64 byte payload, +1=length aware, +2=streaming, +4=fast RX restart, +8=RFM12B interrupt)" "\n"
+"  <p>,<n>n                 - sensor filter of protocol p (1=LaCrosse, 3=EMT7110, 5=TX38IT, 6=WH1080; 0=deny list, 1=allow list, 2=clear)" "\n"
+"  <p>,<n>,<id>n            - add (n=1) or remove (n=0) a sensor ID, n alone reports the filters" "\n"
+"  <n>o                     - output mode (0=every frame, 1=AGG <protocol> ID:<id> N:<frames> <value>:<min>,<mean>,<max> per sensor and window, 2=<SNP|DLT> <protocol> ID:<id> <value>:<x> for changed values)" "\n"
+"  <n>p                     - power save (0=off, 1=sleep between the learned sensor periods, 2=report)" "\n"
+"  <n>q                     - optional fields (+1=RSSI and FEI, +2=radio, +4=time from the WH1080 DCF77 frames)" "\n"
+"  <n>r                     - data rate profile (0=17.241 kbps, 1=9.579 kbps, 2=8.621 kbps)" "\n"
 "  b1,b2,b3,b4s             - send the passed bytes plus the calculated CRC" "\n"
 "  <n>t                     - toggle data rate intervall (0=no toggle, >0=seconds)" "\n"
+"  <n>u                     - WS1600 station record cadence (0=every frame, >0=seconds)" "\n"
 "  <n>v                     - version and configuration report" "\n"
+"  <n>w                     - stored configuration (0=back to the compiled one, 1=save, 2=report, 3=load)" "\n"
 "  <n>y                     - Relay (0=no relay, 1=Relay received packets)" "\n"
 "  <n>x                     - used for tests" "\n"
+"  <n>z                     - statistics (0=frames and timing, 1=SPI clock, 2=verify register shadow)" "\n"
 ;
 
 
@@ -1,4 +1,5 @@
 #include "LaCrosse.h"
+#include "SensorFilter.h"
 
 /*
 * Message Format:
@@ -171,24 +172,7 @@ String LaCrosse::GetFhemDataString(struct Frame *frame) {
 }
 
 bool LaCrosse::DisplayFrame(byte *data, struct Frame &frame, bool fOnlyIfValid) {
-  byte filter[5];
-  filter[0] = 0;
-  filter[1] = 0;
-  filter[2] = 0;
-  filter[3] = 0;
-  filter[4] = 0;
-
-  bool hideIt = false;
-  for (int f = 0; f < 5; f++) {
-    if (frame.ID == filter[f]) {
-      hideIt = true;
-      break;
-    }
-  }
-
-  if (!hideIt && fOnlyIfValid && !frame.IsValid) {
-	  hideIt = true;
-  }
+  bool hideIt = fOnlyIfValid && !frame.IsValid;
 
   if (!hideIt) {
     // MilliSeconds, raw data and crc ok
@@ -197,35 +181,35 @@ bool LaCrosse::DisplayFrame(byte *data, struct Frame &frame, bool fOnlyIfValid)
 
     if (frame.IsValid) {
       // Start
-      Serial.print(" S:");
+      Serial.print(F(" S:"));
       Serial.print(frame.Header, DEC);
 
       // Sensor ID
-      Serial.print(" ID:");
+      Serial.print(F(" ID:"));
       Serial.print(frame.ID, DEC);
 
       // New battery flag
-      Serial.print(" NewBatt:");
+      Serial.print(F(" NewBatt:"));
       Serial.print(frame.NewBatteryFlag, DEC);
 
       // Bit 12
-      Serial.print(" Bit12:");
+      Serial.print(F(" Bit12:"));
       Serial.print(frame.Bit12, DEC);
 
       // Temperature
-      Serial.print(" Temp:");
+      Serial.print(F(" Temp:"));
       Serial.print(frame.Temperature);
 
       // Weak battery flag
-      Serial.print(" WeakBatt:");
+      Serial.print(F(" WeakBatt:"));
       Serial.print(frame.WeakBatteryFlag, DEC);
 
       // Humidity
-      Serial.print(" Hum:");
+      Serial.print(F(" Hum:"));
       Serial.print(frame.Humidity, DEC);
 
       // CRC
-      Serial.print(" CRC:");
+      Serial.print(F(" CRC:"));
       Serial.print(frame.CRC, DEC);
     }
 
@@ -240,16 +224,46 @@ void LaCrosse::AnalyzeFrame(byte *data, bool fOnlyIfValid) {
   DisplayFrame(data, frame, fOnlyIfValid);
 }
 
+// Temperature digits are BCD and the humidity has the values GetFhemDataString accepts
+bool LaCrosse::IsPlausible(byte *data, struct Frame *frame) {
+  return (data[1] & 0x0F) <= 9 && (data[2] >> 4) <= 9 && (data[2] & 0x0F) <= 9
+    && frame->Temperature < 60
+    && (frame->Humidity <= 99 || frame->Humidity == 106 || frame->Humidity == 125);
+}
+
 bool LaCrosse::TryHandleData(byte *data, bool fFhemDisplay) {
   if ((data[0] & 0xF0) >> 4 == 9) {
     struct Frame frame;
+    byte corrected[FRAME_LENGTH];
     DecodeFrame(data, &frame);
+    if (!frame.IsValid && CorrectFrame(data, corrected, FRAME_LENGTH)) {
+      DecodeFrame(corrected, &frame);
+      frame.IsValid = frame.IsValid && IsPlausible(corrected, &frame);
+      if (frame.IsValid) {
+        data = corrected;
+        CountCorrection();
+      }
+    }
     if (frame.IsValid) {
+      if (SensorFilter::IsFiltered(PROTOCOL_LACROSSE, frame.ID)) {
+        return true;
+      }
+      SetLastSensor(PROTOCOL_LACROSSE, frame.ID);
+      SetValue(VALUE_TEMPERATURE, frame.Temperature);
+      if (frame.Humidity <= 100) {
+        SetValue(VALUE_HUMIDITY, frame.Humidity);
+      }
+      SetValue(VALUE_BATTERY, frame.WeakBatteryFlag);
+      if (ForwardValues()) {
+        return true;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
           return fhemString.length() > 0;
   	     }
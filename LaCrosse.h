@@ -22,6 +22,7 @@ public:
   static const byte FRAME_LENGTH = 5;
   static bool USE_OLD_ID_CALCULATION;
   static byte CalculateCRC(byte data[]);
+  static bool IsPlausible(byte *data, struct LaCrosse::Frame *frame);
   static void EncodeFrame(struct LaCrosse::Frame *frame, byte bytes[FRAME_LENGTH]);
   static void DecodeFrame(byte *bytes, struct LaCrosse::Frame *frame);
   static void AnalyzeFrame(byte *data, bool fOnlyIfValid = false);
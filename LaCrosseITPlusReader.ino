@@ -16,9 +16,10 @@
 
 #include "RFMxx.h"
 #include "SensorBase.h"
-#ifdef USE_TIME_H
-#include <Time.h>
-#endif
+#include "SensorFilter.h"
+#include "Aggregator.h"
+#include "DeltaReporter.h"
+#include "Clock.h"
 #ifdef USE_SPI_H
 #include <SPI.h>
 #endif
@@ -31,6 +32,11 @@
 #include "WS1600.h"
 #include "JeeLink.h"
 #include "Transmitter.h"
+#include "Afc.h"
+#include "Scanner.h"
+#include "PowerSave.h"
+#include "Config.h"
+#include "FrameDetector.h"
 #include "Help.h"
 
 // --- Configuration ---------------------------------------------------------
@@ -40,6 +46,7 @@ bool fOnlyIfValid           = true;
 bool fFhemDisplay           = false;                // set to false for text display
 #define ENABLE_ACTIVITY_LED   1                     // set to 0 if the blue LED bothers
 #define USE_OLD_IDS           0                     // Set to 1 to use the old ID calcualtion
+#define RADIO_COUNT           1                     // 1 or 2 radios on the SPI bus, each pinned to a data rate
 // The following settings can also be set from FHEM
 bool    DEBUG               = 0;                    // set to 1 to see debug messages
 
@@ -59,6 +66,20 @@ bool RELAY                  = 0;                    // If 1 all received packets
 unsigned long lastToggle = 0;
 byte commandData[32];
 byte commandDataPointer = 0;
+// Input is taken as a whole line, commands end with their letter
+#ifdef ESP32
+#define COMMAND_LINE_SIZE 64
+#else
+#define COMMAND_LINE_SIZE 32
+#endif
+char commandLine[COMMAND_LINE_SIZE];
+byte commandLineLength = 0;
+bool commandLineOverflow = false;         // dropping a number longer than the buffer
+// Radio changes of a command line, applied together when the line is done
+int pendingProfile = -1;
+unsigned long pendingDataRate = 0;
+unsigned long pendingFrequency = 0;
+int pendingReceiveMode = -1;
 #ifndef USE_SX127x
 #ifndef USE_SPI_H
 RFMxx rfm(11, 12, 13, 10, 2);
@@ -90,15 +111,47 @@ SSD1306 display(0x3c, 4, 15);
 RFMxx rfm(SS, DI0, RST); // need RST?
 
 #endif
+#if RADIO_COUNT > 1
+#ifndef USE_SPI_H
+#error "Multiple radios need the SPI.h build"
+#endif
+#if RADIO_COUNT > 2
+#error "Only a second radio is wired up, add the pins and the data rate of the others"
+#endif
+// The additional radios share the SPI bus, each with its own SS and IRQ pin
+RFMxx rfm2(8, 3);
+RFMxx *radios[RADIO_COUNT] = { &rfm, &rfm2 };
+unsigned long RADIO_DATA_RATE[RADIO_COUNT] = { (unsigned long)dataRateFast, (unsigned long)dataRateWs1600 };
+#else
+RFMxx *radios[RADIO_COUNT] = { &rfm };
+#endif
+unsigned long radioFrames[RADIO_COUNT];
+unsigned long radioSplitFrames[RADIO_COUNT];
+unsigned long radioPolls[RADIO_COUNT];
+unsigned long radioPollMicros[RADIO_COUNT];
+unsigned long bootMillis = 0;                  // millis() at the start of setup()
+unsigned long firstFrameMillis = 0;
+unsigned long rxArmedMillis = 0;
+Config::Settings defaultSettings;
+
 JeeLink jeeLink;
 Transmitter transmitter(&rfm);
+Afc afc(&rfm);
+#ifdef USE_SCANNER
+Scanner scanner(&rfm);
+#endif
+#ifdef USE_POWERSAVE
+PowerSave powerSave(radios, RADIO_COUNT);
+#endif
 
 
 static void HandleSerialPort(char c) {
   static unsigned long value;
 
   if (c == ',') {
-    commandData[commandDataPointer++] = value;
+    if (commandDataPointer < sizeof(commandData) - 1) {
+      commandData[commandDataPointer++] = value;
+    }
     value = 0;
   }
   else if ('0' <= c && c <= '9') {
@@ -119,24 +172,20 @@ static void HandleSerialPort(char c) {
       jeeLink.EnableLED(value);
       break;
     case 'r':
-      // Data rate
-      switch (value) {
-		  case 0:
-		  	DATA_RATE = (unsigned long)dataRateFast;
-		  	break;
-		  case 1:
-		  	DATA_RATE = (unsigned long)dataRateFast;
-		  	break;
-		  case 2:
-		  	DATA_RATE = (unsigned long)dataRateWs1600;
-		  	break;
-	  }
-      //DATA_RATE = value ? 9579ul : 17241ul;
-      rfm.SetDataRate(DATA_RATE);
+      // Data rate profile: 0=17241, 1=9579, 2=8621
+#if RADIO_COUNT > 1
+      Serial.println(F("Every radio keeps its own data rate"));
+#else
+      pendingProfile = value;
+#endif
       break;
     case 't':
       // Toggle data rate
+#if RADIO_COUNT > 1
+      Serial.println(F("Every radio keeps its own data rate"));
+#else
       TOGGLE_DATA_RATE = value;
+#endif
       break;
     case 'v':
       // Version info
@@ -162,13 +211,125 @@ static void HandleSerialPort(char c) {
       break;
 
     case 'f':
-      rfm.SetFrequency(value);
+      // Frequency in kHz, for all radios
+      pendingFrequency = value;
+      break;
+
+    case 'b':
+      // Single bit error correction of CRC-8 frames
+      SensorBase::EnableCorrection(value);
+      break;
+
+    case 'e':
+      // AFC: 0=off, 1=on, 2=report the offset table, it tunes the first radio only
+      if (value == 2) {
+        afc.Report();
+      }
+      else {
+        afc.Enable(value);
+      }
       break;
 
     case 'y':
       RELAY = value;
       break;
 
+    case 'w':
+      // Stored configuration: 0=back to the compiled one, 1=save, 2=report, 3=load
+      HandleCommandW(value);
+      break;
+
+    case 'z':
+      // Statistics: 0=frames and timing, 1=SPI clock, 2=verify the register shadow
+      HandleCommandZ(value);
+      break;
+
+    case 'm':
+      // Receive mode: 0=fixed 64 byte payload, +1=length aware, +2=streaming, +4=fast RX restart, +8=RFM12B interrupt
+      pendingReceiveMode = value;
+      break;
+
+    case 'n':
+      // Sensor filter: <protocol>,<0=deny,1=allow,2=clear>n or <protocol>,<0=remove,1=add>,<id>n
+      commandData[commandDataPointer] = value;
+      HandleCommandN(commandData, ++commandDataPointer, value);
+      commandDataPointer = 0;
+      break;
+
+    case 'o':
+      // Output mode: 0=every frame, 1=summary per sensor and window, 2=changed values only
+      if (!IsOutputModeBuilt(value)) {
+        Serial.println(F("Output mode not in this build"));
+        break;
+      }
+#ifdef USE_AGGREGATOR
+      Aggregator::Flush();
+#endif
+      SensorBase::SetOutputMode(value);
+      break;
+
+#ifdef USE_AGGREGATOR
+    case 'g':
+      // Aggregation window in seconds
+      Aggregator::SetWindow(value);
+      break;
+#endif
+
+#ifdef USE_DELTA_REPORTER
+    case 'j':
+      // Deadband of a value for the delta output: <value>,<tenths>j
+      commandData[commandDataPointer] = value;
+      if (++commandDataPointer == 2) {
+        DeltaReporter::SetDeadband(commandData[0], value);
+      }
+      DeltaReporter::Report();
+      commandDataPointer = 0;
+      break;
+
+    case 'k':
+      // Minutes between full snapshots in the delta output
+      DeltaReporter::SetSnapshotMinutes(value);
+      break;
+#endif
+
+    case 'u':
+      // WS1600 station records: 0=with every frame, >0=seconds between records
+      WS1600::SetCadence(value);
+      break;
+
+#ifdef USE_POWERSAVE
+    case 'p':
+      // Power save: 0=off, 1=sleep between the predicted frames, 2=report
+      if (value == 2) {
+        powerSave.Report();
+      }
+      else {
+        powerSave.Enable(value);
+      }
+      break;
+#endif
+
+#ifdef USE_SCANNER
+    case 'h':
+      // Frequency scan: 0=stop, 1=863 to 870 MHz, 2=report or <width>,<centre>h
+      commandData[commandDataPointer] = value;
+      HandleCommandH(commandData, ++commandDataPointer, value);
+      commandDataPointer = 0;
+      break;
+#endif
+
+    case 'l':
+      // RFM69 listen mode: 0=off, 1=on, 2=report or <idle>,<rx>,<rssi>l
+      commandData[commandDataPointer] = value;
+      HandleCommandL(commandData, ++commandDataPointer);
+      commandDataPointer = 0;
+      break;
+
+    case 'q':
+      // Optional fields: 1=RSSI and frequency error, 2=radio, 4=time
+      SensorBase::SetOptionalFields(value);
+      break;
+
     default:
       HandleCommandV();
       Help::Show();
@@ -182,11 +343,194 @@ static void HandleSerialPort(char c) {
   }
 }
 
+// A line with several radio commands, e.g. "1r 868300f 1m", reconfigures the radios once
+static void ApplyRadioChanges() {
+  if (pendingProfile < 0 && pendingDataRate == 0 && pendingFrequency == 0 && pendingReceiveMode < 0) {
+    return;
+  }
+  for (byte r = 0; r < RADIO_COUNT; r++) {
+    radios[r]->EnableReceiver(false);
+  }
+  if (pendingDataRate > 0) {
+    rfm.SetDataRate(pendingDataRate);
+    DATA_RATE = rfm.GetDataRate();
+  }
+  if (pendingProfile >= 0) {
+    rfm.SetProfile(pendingProfile);
+    DATA_RATE = rfm.GetDataRate();
+  }
+  if (pendingFrequency > 0) {
+    INITIAL_FREQ = pendingFrequency;
+    afc.SetBaseFrequency(pendingFrequency);
+#if RADIO_COUNT > 1
+    for (byte r = 1; r < RADIO_COUNT; r++) {
+      radios[r]->SetFrequency(pendingFrequency);
+    }
+#endif
+  }
+  if (pendingReceiveMode >= 0) {
+    for (byte r = 0; r < RADIO_COUNT; r++) {
+      radios[r]->SetReceiveMode(pendingReceiveMode);
+    }
+  }
+  for (byte r = 0; r < RADIO_COUNT; r++) {
+    radios[r]->EnableReceiver(RECEIVER_ENABLED);
+  }
+  pendingProfile = -1;
+  pendingDataRate = 0;
+  pendingFrequency = 0;
+  pendingReceiveMode = -1;
+}
+
+// A number may still be coming after a digit or a comma
+static bool IsOpen(char c) {
+  return c == ',' || ('0' <= c && c <= '9');
+}
+
+// Run the commands up to the last command letter or line break, the open tail moves
+// to the front of the buffer and waits for the rest of its number
+static void RunCommandLine() {
+  byte end = commandLineLength;
+  while (end > 0 && IsOpen(commandLine[end - 1])) {
+    end--;
+  }
+  if (end == 0) {
+    return;
+  }
+  for (byte i = 0; i < end; i++) {
+    HandleSerialPort(commandLine[i]);
+  }
+  commandLineLength -= end;
+  memmove(commandLine, commandLine + end, commandLineLength);
+  ApplyRadioChanges();
+}
+
+// Take everything the serial port has, a pasted command sequence must not wait in the
+// RX buffer of the core while frames are received. Only a single number longer than
+// the buffer is dropped, together with its command letter.
+static void HandleSerialInput() {
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (commandLineLength == COMMAND_LINE_SIZE) {
+      RunCommandLine();
+      if (commandLineLength == COMMAND_LINE_SIZE) {
+        // Nothing ran, the buffer holds a single number
+        commandLineLength = 0;
+        commandLineOverflow = true;
+      }
+    }
+    if (commandLineOverflow) {
+      if (!IsOpen(c)) {
+        commandLineOverflow = false;
+        Serial.println(F("Command line too long"));
+      }
+      continue;
+    }
+    commandLine[commandLineLength++] = c;
+  }
+  RunCommandLine();
+}
+
+// The summary and delta output are left out of the ATmega328 build
+bool IsOutputModeBuilt(byte mode) {
+#ifndef USE_AGGREGATOR
+  if (mode == SensorBase::OUTPUT_AGGREGATE) {
+    return false;
+  }
+#endif
+#ifndef USE_DELTA_REPORTER
+  if (mode == SensorBase::OUTPUT_DELTA) {
+    return false;
+  }
+#endif
+  return true;
+}
+
+void CollectSettings(Config::Settings &settings) {
+  memset(&settings, 0, sizeof(settings));
+  settings.dataRate = DATA_RATE;
+  settings.frequency = INITIAL_FREQ;
+  settings.toggleInterval = TOGGLE_DATA_RATE;
+  settings.receiveMode = rfm.GetReceiveMode();
+  settings.outputMode = SensorBase::GetOutputMode();
+  settings.optionalFields = SensorBase::GetOptionalFields();
+#ifdef USE_AGGREGATOR
+  settings.aggregateWindow = Aggregator::GetWindow();
+#endif
+  settings.flags = (RELAY ? Config::FLAG_RELAY : 0)
+    | (afc.IsEnabled() ? Config::FLAG_AFC : 0)
+    | (SensorBase::IsCorrectionEnabled() ? Config::FLAG_CORRECTION : 0)
+    | (transmitter.IsEnabled() ? Config::FLAG_TRANSMIT : 0);
+  settings.transmitId = transmitter.GetId();
+  settings.transmitInterval = transmitter.GetInterval();
+  settings.transmitDataRate = transmitter.GetDataRate();
+}
+
+// The radio settings go through ApplyRadioChanges, the radios are set up once
+void ApplySettings(Config::Settings &settings) {
+#if RADIO_COUNT == 1
+  // Every radio of a multi-radio build keeps its own data rate, as with the r and t commands
+  pendingDataRate = settings.dataRate;
+  TOGGLE_DATA_RATE = settings.toggleInterval;
+#endif
+  pendingFrequency = settings.frequency;
+  pendingReceiveMode = settings.receiveMode;
+  RELAY = settings.flags & Config::FLAG_RELAY;
+#ifdef USE_AGGREGATOR
+  Aggregator::Flush();
+  Aggregator::SetWindow(settings.aggregateWindow);
+#endif
+  if (IsOutputModeBuilt(settings.outputMode)) {
+    SensorBase::SetOutputMode(settings.outputMode);
+  }
+  SensorBase::SetOptionalFields(settings.optionalFields);
+  SensorBase::EnableCorrection(settings.flags & Config::FLAG_CORRECTION);
+  transmitter.SetParameters(settings.transmitId, settings.transmitInterval, false, 0, settings.transmitDataRate);
+  transmitter.Enable(settings.flags & Config::FLAG_TRANSMIT);
+  ApplyRadioChanges();
+  // Takes the base frequency and bandwidth of the profile just applied
+  afc.Enable(settings.flags & Config::FLAG_AFC);
+}
+
+void HandleCommandW(byte value) {
+  Config::Settings settings;
+  switch (value) {
+  case 0:
+    Config::Erase();
+    ApplySettings(defaultSettings);
+    break;
+  case 1:
+    CollectSettings(settings);
+    if (!Config::Save(settings)) {
+      Serial.println(F("Config unchanged"));
+    }
+    break;
+  case 3:
+    if (Config::Load(settings)) {
+      ApplySettings(settings);
+    }
+    break;
+  }
+  Config::Report();
+  ReportBoot();
+}
+
+void ReportBoot() {
+  // Time from the start of setup() to the receiver in RX and to the first frame, 0 until one was received
+  Serial.print(F("[Boot RXArmed:"));
+  Serial.print(rxArmedMillis);
+  Serial.print(F("ms FirstFrame:"));
+  Serial.print(firstFrameMillis);
+  Serial.println(F("ms]"));
+}
+
 void SetDebugMode(boolean mode) {
   DEBUG = mode;
   LevelSenderLib::SetDebugMode(mode);
   WT440XH::SetDebugMode(mode);
-  rfm.SetDebugMode(mode);
+  for (byte r = 0; r < RADIO_COUNT; r++) {
+    radios[r]->SetDebugMode(mode);
+  }
 }
 
 void HandleCommandS(byte *data, byte size) {
@@ -234,6 +578,104 @@ void HandleCommandC(byte *values, byte size){
 }
 
 
+void HandleCommandN(byte *values, byte size, unsigned long id) {
+  // 1,1,23n    -> add LaCrosse ID 23 to the list
+  // 1,1n       -> the LaCrosse list is an allow list
+  // 3,1,5123n  -> add EMT7110 ID 5123, the ID is the last value so it may exceed a byte
+  // Protocols: 1=LaCrosse, 3=EMT7110, 5=TX38IT, 6=WH1080
+  if (size == 3) {
+    if (values[1]) {
+      if (!SensorFilter::Add(values[0], id)) {
+        Serial.println(F("Filter full or ID out of range"));
+      }
+    }
+    else {
+      SensorFilter::Remove(values[0], id);
+    }
+  }
+  else if (size == 2) {
+    if (values[1] == 2) {
+      SensorFilter::Clear(values[0]);
+    }
+    else {
+      SensorFilter::SetMode(values[0], values[1]);
+    }
+  }
+  SensorFilter::Report();
+}
+
+#ifdef USE_SCANNER
+void HandleCommandH(byte *values, byte size, unsigned long kHz) {
+  // 1h          -> sweep 863 to 870 MHz, then dwell on the peaks
+  // 10,868300h  -> sweep 1 MHz around 868.3 MHz, the width in 100 kHz, the centre may exceed a byte
+  bool started = true;
+  if (size == 2) {
+    unsigned long half = values[0] * 50UL;
+    started = scanner.Start(kHz - half, kHz + half);
+  }
+  else if (values[0] == 1) {
+    started = scanner.Start(863000, 870000);
+  }
+  else if (values[0] == 2) {
+    scanner.Report();
+    return;
+  }
+  else {
+    scanner.Stop();
+  }
+  if (!started) {
+    Serial.println(F("Scan needs an RFM69 or SX127x in RX and at most 20 MHz"));
+  }
+}
+#endif
+
+void HandleCommandL(byte *values, byte size) {
+  // 1l          -> listen with the timing of the data rate profile
+  // 20,9,100l   -> idle 20 and RX 9 times 64 us, wake up above -100 dBm
+  // 0,0,95l     -> profile timing, wake up above -95 dBm
+  if (size == 1 && values[0] == 2) {
+    ReportListen();
+    return;
+  }
+  for (byte r = 0; r < RADIO_COUNT; r++) {
+    if (size == 3) {
+      radios[r]->SetListenTiming(values[0], values[1], values[2]);
+    }
+    // Switching it off is nothing to report on the other radios
+    bool enable = size == 3 || values[0] == 1;
+    if (!radios[r]->EnableListen(enable) && enable) {
+      Serial.println(F("Listen mode needs an RFM69"));
+    }
+  }
+  ReportListen();
+}
+
+void ReportListen() {
+  for (byte r = 0; r < RADIO_COUNT; r++) {
+    Serial.print(F("[Listen Radio:"));
+    Serial.print(r);
+    if (!radios[r]->IsListening()) {
+      Serial.println(F(" off]"));
+      continue;
+    }
+    Serial.print(F(" Idle:"));
+    Serial.print(radios[r]->GetListenIdleMicros());
+    Serial.print(F("us RX:"));
+    Serial.print(radios[r]->GetListenRxMicros());
+    Serial.print(F("us RSSI:-"));
+    Serial.print(radios[r]->GetListenRssi());
+    // Average current without a signal, the frames add their RX time
+    Serial.print(F(" Current:"));
+    Serial.print(radios[r]->GetListenCurrent());
+    Serial.print(F("uA Frames:"));
+    Serial.print(radios[r]->GetListenFrames());
+    // Wake ups by noise or frames that were not complete
+    Serial.print(F(" Timeouts:"));
+    Serial.print(radios[r]->GetListenTimeouts());
+    Serial.println(F("]"));
+  }
+}
+
 // This function is for testing
 void HandleCommandX(byte value) {
   LaCrosse::Frame frame;
@@ -245,11 +687,11 @@ void HandleCommandX(byte value) {
   frame.Humidity = value;
 
   if (DEBUG) {
-    Serial.print("TX: T=");
+    Serial.print(F("TX: T="));
     Serial.print(frame.Temperature);
-    Serial.print(" H=");
+    Serial.print(F(" H="));
     Serial.print(frame.Humidity);
-    Serial.print(" NB=");
+    Serial.print(F(" NB="));
     Serial.print(frame.NewBatteryFlag);
     Serial.println();
   }
@@ -262,93 +704,44 @@ void HandleCommandX(byte value) {
 }
 
 void HandleCommandV() {
-  Serial.print("\n[");
+  Serial.print(F("\n["));
   Serial.print(PROGNAME);
   Serial.print('.');
   Serial.print(PROGVERS);
 
-  Serial.print(" (");
+  Serial.print(F(" ("));
   Serial.print(rfm.GetRadioName());
-  Serial.print(")");
+  Serial.print(F(")"));
 
-  Serial.print(" @");
+  Serial.print(F(" @"));
   if (TOGGLE_DATA_RATE == 30) {
-    Serial.print("AutoToggleWH1080 ");
+    Serial.print(F("AutoToggleWH1080 "));
     Serial.print(TOGGLE_DATA_RATE);
-    Serial.print(" Seconds ");
+    Serial.print(F(" Seconds "));
   }
   else if (TOGGLE_DATA_RATE) {
-    Serial.print("AutoToggle ");
+    Serial.print(F("AutoToggle "));
     Serial.print(TOGGLE_DATA_RATE);
-    Serial.print(" Seconds ");
+    Serial.print(F(" Seconds "));
   }
 //  else {
     Serial.print(DATA_RATE);
-    Serial.print(" kbps");
+    Serial.print(F(" kbps"));
 //  }
 
-  Serial.print(" / ");
+  Serial.print(F(" / "));
   Serial.print(rfm.GetFrequency());
-  Serial.print(" kHz");
+  Serial.print(F(" kHz"));
 
   Serial.println(']');
 }
 
-// **********************************************************************
-void loop(void) {
-  // Handle the commands from the serial port
-  // ----------------------------------------
-  if (Serial.available()) {
-    HandleSerialPort(Serial.read());
-  }
-
-  // Handle the data rate
-  // --------------------
-  if (TOGGLE_DATA_RATE > 0) {
-    // After about 50 days millis() will overflow to zero
-    if (millis() < lastToggle) {
-      lastToggle = 0;
-    }
-    if (fForceToggle || (millis() > lastToggle + TOGGLE_DATA_RATE * 1000)) {
-		if (!fForceToggle && ((TOGGLE_DATA_RATE == 30) && (DATA_RATE == (unsigned long)dataRateFast) && (millis() > (lastWh1080 + 5 * TOGGLE_DATA_RATE * 1000)))) {
-			// WH1080 48 seconds interval so try another 30 seconds
-			lastWh1080 = millis();
-			Serial.println("Skip toggle for WH1080");
-			HandleCommandV();
-		}
-		else {
-		  fForceToggle = false;
-		  if (DATA_RATE == (unsigned long)dataRateWs1600) {
-			DATA_RATE = (unsigned long)dataRateFast;
-		  }
-		  else {
-			DATA_RATE = (unsigned long)dataRateWs1600;
-		  }
-
-		  rfm.SetDataRate(DATA_RATE);
-		  if (TOGGLE_DATA_RATE == 30) {
-  		  	HandleCommandV();
-		  }
-	  }
-      lastToggle = millis();
-    }
-  }
-
-  // Priodically transmit
-  // --------------------
-  if (transmitter.Transmit()) {
-    jeeLink.Blink(2);
-    rfm.EnableReceiver(RECEIVER_ENABLED);
-  }
-
-  // Handle the data reception
-  // -------------------------
-  if (RECEIVER_ENABLED) {
-      byte payload[PAYLOADSIZE];
-      byte payLoadSize;
-      byte packetCount;
-      if (rfm.ReceiveGetPayloadWhenReady(payload, payLoadSize, packetCount)) {
+// Decode and output one payload, all radios feed this pipeline
+static void HandleReceivedPayload(byte radioIndex, byte *payload, byte payLoadSize, byte packetCount) {
+  RFMxx *radio = radios[radioIndex];
 		byte startNibble = (payload[0] & 0xF0)>>4;
+		SensorBase::SetSignal(radio->GetRssi(), radio->GetFei());
+		SensorBase::SetSource(radioIndex);
       if(ANALYZE_FRAMES) {
         LaCrosse::AnalyzeFrame(payload, fOnlyIfValid);
         LevelSenderLib::AnalyzeFrame(payload, fOnlyIfValid);
@@ -358,12 +751,12 @@ void loop(void) {
         case 0x5: // WS3000 weather
         case 0x6: // WS3000 time
         case 0xA: //WS4000 WH1080 weather
-			if ((packetCount <= 1) || (DATA_RATE != dataRateFast)) {
+			if ((packetCount <= 1) || (radio->GetDataRate() != dataRateFast)) {
 				WS1600::AnalyzeFrame(payload, fOnlyIfValid);
 				break;
 			}
         case 0xB: //WS4000 WH1080 time
-			if ((packetCount > WH1080_MIN_PACKET_COUNT) || (DATA_RATE == dataRateFast)) {
+			if ((packetCount > WH1080_MIN_PACKET_COUNT) || (radio->GetDataRate() == dataRateFast)) {
 				WH1080::AnalyzeFrame(payload, packetCount, fOnlyIfValid);
 			}
 			break;
@@ -374,15 +767,16 @@ void loop(void) {
         jeeLink.Blink(1);
 
         if (DEBUG) {
-          Serial.print("\nEnd receiving, HEX raw data: ");
+          Serial.print(F("\nEnd receiving, HEX raw data: "));
           for (int i = 0; i < 16; i++) {
             Serial.print(payload[i], HEX);
-            Serial.print(" ");
+            Serial.print(F(" "));
           }
           Serial.println();
         }
 
         byte frameLength = 0;
+        SensorBase::SetLastSensor(SensorBase::PROTOCOL_NONE, 0);
 
         // Try LaCrosse like TX29DTH
         if (LaCrosse::TryHandleData(payload, fFhemDisplay)) {
@@ -408,7 +802,7 @@ void loop(void) {
         else if (TX38IT::TryHandleData(payload, fFhemDisplay)) {
           frameLength = TX38IT::FRAME_LENGTH;
         }
-        else if ((DATA_RATE == dataRateFast) && (packetCount > WH1080_MIN_PACKET_COUNT)) { // Try WH1080 with frameLength 9 or 10
+        else if ((radio->GetDataRate() == dataRateFast) && (packetCount > WH1080_MIN_PACKET_COUNT)) { // Try WH1080 with frameLength 9 or 10
 			switch(startNibble) {
 			case 0x5: // WS3000 weather
 			case 0x6: // WS3000 time
@@ -425,7 +819,7 @@ void loop(void) {
 			}
 			//frameLength = 0;
 		}
-		else if (startNibble = 0xA) { // try ws1600 with variable framelength
+		else if (startNibble == 0xA) { // try ws1600 with variable framelength
 #if 0
 				static unsigned long lastMillis;
 				byte datasets = payload[1] & 0x0F; // 2bytes, 4 nibbles
@@ -439,26 +833,55 @@ void loop(void) {
 	            Serial.println();
 #endif
 				frameLength = WS1600::TryHandleData(payload, fFhemDisplay);
-	            //Serial.print(" frameLength");
+	            //Serial.print(F(" frameLength"));
 	            //Serial.print(frameLength);
 	            //Serial.println();
 		}
 
+		if (frameLength == 0 && radio->GetDataRate() == dataRateFast
+		  && (startNibble == 0x5 || startNibble == 0x6 || startNibble == 0xA || startNibble == 0xB)) {
+			// Copies of a WH1080 burst with bit errors, a majority vote may still give the frame
+			byte voted[LEN_MAX];
+			byte votes;
+			WH1080::AddRepeat(payload, packetCount);
+			if (WH1080::VoteRepeats(voted, votes) > 0) {
+				frameLength = WH1080::TryHandleData(voted, votes, fFhemDisplay);
+			}
+		}
+
+		if (frameLength > 0 && radio == &rfm) {
+#ifdef USE_SCANNER
+			if (scanner.IsActive()) {
+				// The scan owns the frequency, the frame tells where its sensor is
+				scanner.Update(SensorBase::GetLastProtocol(), SensorBase::GetLastID(), rfm.GetRssi(), rfm.GetFei());
+			}
+			else
+#endif
+			{
+				afc.Update(SensorBase::GetLastProtocol(), SensorBase::GetLastID(), rfm.GetFei());
+			}
+		}
+#ifdef USE_POWERSAVE
+		if (frameLength > 0) {
+			powerSave.Update(SensorBase::GetLastProtocol(), SensorBase::GetLastID());
+		}
+#endif
+
 		if (frameLength == 0) {
 			// MilliSeconds and the raw data bytes
 			static unsigned long lastMillis;
 			SensorBase::DisplayFrame(lastMillis, "Unknown", false, payload, (payLoadSize > 16) ? 18 : payLoadSize);
 
-			Serial.print(" Size:");
+			Serial.print(F(" Size:"));
 			Serial.print(payLoadSize);
-            Serial.print(" #:");
+            Serial.print(F(" #:"));
 			Serial.print(packetCount);
-            //Serial.print(": ");
+            //Serial.print(F(": "));
 			for (byte i = 8; i < payLoadSize; i++) { // test if crc with itself is 0
 				if (SensorBase::CalculateCRC(payload, i) == 0) {
-					Serial.print(" crclen ");
+					Serial.print(F(" crclen "));
 					Serial.print(i);
-					Serial.print(":");
+					Serial.print(F(":"));
 				}
 			}
 
@@ -476,21 +899,242 @@ void loop(void) {
 
         if (RELAY && frameLength > 0) {
           delay(64);
-          rfm.SendArray(payload, frameLength);
-          if (DEBUG) { Serial.println("Relayed"); }
+          radio->SendArray(payload, frameLength);
+          if (DEBUG) { Serial.println(F("Relayed")); }
         }
       }
-      rfm.EnableReceiver(true);
+}
+
+// A payload can hold a second transmission behind the first frame, each one has its own sync word
+static byte HandleFollowingFrames(byte radioIndex, byte *payload, byte payLoadSize, byte packetCount) {
+  byte frame[PAYLOADSIZE];
+  byte count = 0;
+  word bit = FrameDetector::FindFrame(payload, payLoadSize) * 8;
+  while ((bit = FrameDetector::FindSync(payload, payLoadSize, bit)) > 0) {
+    byte length = (payLoadSize * 8 - bit) / 8;
+    memset(frame, 0, sizeof(frame));
+    FrameDetector::ExtractBits(payload, bit, frame, length);
+    byte frameLength = FrameDetector::FindFrame(frame, length);
+    if (frameLength > 0) {
+      HandleReceivedPayload(radioIndex, frame, frameLength, packetCount);
+      bit += frameLength * 8;
+      count++;
+    }
+  }
+  return count;
+}
+
+void HandleCommandZ(byte value) {
+  if (value == 1) {
+    for (byte r = 0; r < RADIO_COUNT; r++) {
+      Serial.print(F("[Radio "));
+      Serial.print(r);
+      Serial.print(F(" SPI:"));
+      Serial.print(radios[r]->MeasureSpiClock());
+      Serial.println(F(" kHz]"));
     }
+    return;
+  }
+  if (value == 2) {
+    for (byte r = 0; r < RADIO_COUNT; r++) {
+      Serial.print(F("[Radio "));
+      Serial.print(r);
+      Serial.print(F(" Shadow mismatches:"));
+      Serial.print(radios[r]->VerifyShadow());
+      Serial.println(F("]"));
+    }
+    return;
+  }
+
+  unsigned long minutes = millis() / 60000;
+  for (byte r = 0; r < RADIO_COUNT; r++) {
+    Serial.print(F("[Radio "));
+    Serial.print(r);
+    Serial.print(' ');
+    Serial.print(radios[r]->GetRadioName());
+    Serial.print(' ');
+    Serial.print(radios[r]->GetDataRate());
+    Serial.print(F(" kbps Frames:"));
+    Serial.print(radioFrames[r]);
+    Serial.print(F(" PerHour:"));
+    Serial.print(minutes ? radioFrames[r] * 60 / minutes : radioFrames[r]);
+    // Frames found behind the first one of a payload
+    Serial.print(F(" Split:"));
+    Serial.print(radioSplitFrames[r]);
+    Serial.print(F(" SplitPerHour:"));
+    Serial.print(minutes ? radioSplitFrames[r] * 60 / minutes : radioSplitFrames[r]);
+    // Copies merged into a collected payload, payloads handed over early for a new one
+    Serial.print(F(" Merged:"));
+    Serial.print(radios[r]->GetMergedRepeats());
+    Serial.print(F(" Evicted:"));
+    Serial.print(radios[r]->GetEvictedRepeats());
+    // Time spent polling a radio that had nothing, the cost of the round robin
+    Serial.print(F(" Poll:"));
+    Serial.print(radioPolls[r] ? radioPollMicros[r] / radioPolls[r] : 0);
+    // From sync word to the payload handed to the decoders
+    Serial.print(F("us Latency:"));
+    Serial.print(radios[r]->GetLatency());
+    Serial.print(F("us Max:"));
+    Serial.print(radios[r]->GetLatencyMax());
+    // Time the radio was not in RX: per frame, per hour and in percent of the uptime
+    unsigned long blindMillis = radios[r]->GetBlindMillis();
+    unsigned long blindCount = radios[r]->GetBlindCount();
+    Serial.print(F("us Blind:"));
+    Serial.print(blindCount ? blindMillis * 1000.0 / blindCount : 0, 0);
+    Serial.print(F("us BlindPerHour:"));
+    Serial.print(minutes ? blindMillis * 60 / minutes : blindMillis);
+    Serial.print(F("ms BlindPercent:"));
+    Serial.print(blindMillis * 100.0 / millis(), 3);
+    Serial.print(F(" SpiPerFrame:"));
+    Serial.print(radios[r]->GetSpiTransactionsPerFrame());
+    // Duration of the last data rate profile switch
+    Serial.print(F(" Switch:"));
+    Serial.print(radios[r]->GetProfileSwitchMicros());
+    Serial.print(F("us"));
+    if (radios[r]->GetReceiveMode() & RFMxx::RX_IRQ_RING) {
+      // Bytes the interrupt could not store because the sketch did not take them
+      Serial.print(F(" RingOverflows:"));
+      Serial.print(radios[r]->GetRingOverflows());
+    }
+    Serial.println(F("]"));
+  }
+  // WH1080 frames rebuilt from damaged copies
+  Serial.print(F("[WH1080 Voted:"));
+  Serial.print(WH1080::GetVotedFrames());
+  Serial.print(F(" PerHour:"));
+  Serial.print(minutes ? WH1080::GetVotedFrames() * 60 / minutes : WH1080::GetVotedFrames());
+  Serial.println(F("]"));
+  Clock::Report();
+  ReportBoot();
+#ifdef USE_POWERSAVE
+  if (powerSave.IsEnabled()) {
+    powerSave.Report();
+  }
+#endif
+  if (rfm.IsListening()) {
+    ReportListen();
   }
+  // Frames of sensors in the filter lists
+  Serial.print(F("[Filtered:"));
+  Serial.print(SensorFilter::GetFilteredCount());
+  Serial.println(F("]"));
+  // Frames repaired by the CRC-8 syndrome
+  Serial.print(F("[Corrected:"));
+  Serial.print(SensorBase::GetCorrections());
+  Serial.print(F(" PerHour:"));
+  Serial.print(minutes ? SensorBase::GetCorrections() * 60 / minutes : SensorBase::GetCorrections());
+  Serial.println(F("]"));
 }
 
+// **********************************************************************
+void loop(void) {
+  // Handle the commands from the serial port
+  // ----------------------------------------
+  HandleSerialInput();
+
+  // Handle the data rate
+  // --------------------
+  if (TOGGLE_DATA_RATE > 0) {
+    // After about 50 days millis() will overflow to zero
+    if (millis() < lastToggle) {
+      lastToggle = 0;
+    }
+    if (fForceToggle || (millis() > lastToggle + TOGGLE_DATA_RATE * 1000)) {
+		if (!fForceToggle && ((TOGGLE_DATA_RATE == 30) && (DATA_RATE == (unsigned long)dataRateFast) && (millis() > (lastWh1080 + 5 * TOGGLE_DATA_RATE * 1000)))) {
+			// WH1080 48 seconds interval so try another 30 seconds
+			lastWh1080 = millis();
+			Serial.println(F("Skip toggle for WH1080"));
+			HandleCommandV();
+		}
+		else {
+		  fForceToggle = false;
+		  if (DATA_RATE == (unsigned long)dataRateWs1600) {
+			DATA_RATE = (unsigned long)dataRateFast;
+		  }
+		  else {
+			DATA_RATE = (unsigned long)dataRateWs1600;
+		  }
+
+		  rfm.SetDataRate(DATA_RATE);
+		  if (TOGGLE_DATA_RATE == 30) {
+  		  	HandleCommandV();
+		  }
+	  }
+      lastToggle = millis();
+    }
+  }
+
+  // Keep the AFC temperature compensation up to date
+  // --------------------------------------------------
+  afc.Handle();
+
+#ifdef USE_SCANNER
+  // Step the frequency scan
+  // -----------------------
+  scanner.Handle();
+#endif
+
+  // Advance the wall clock
+  // ----------------------
+  Clock::Handle();
+
+  // Send the summaries when the aggregation window ends
+  // -----------------------------------------------------
+#ifdef USE_AGGREGATOR
+  if (SensorBase::GetOutputMode() == SensorBase::OUTPUT_AGGREGATE) {
+    Aggregator::Handle();
+  }
+#endif
+
+  // Priodically transmit
+  // --------------------
+  if (transmitter.Transmit()) {
+    jeeLink.Blink(2);
+    rfm.EnableReceiver(RECEIVER_ENABLED);
+  }
+
+  // Handle the data reception
+  // -------------------------
+  if (RECEIVER_ENABLED) {
+    // Poll the radios round robin, starting with another one each loop
+    static byte firstRadio = 0;
+    for (byte n = 0; n < RADIO_COUNT; n++) {
+      byte r = (firstRadio + n) % RADIO_COUNT;
+      byte payload[PAYLOADSIZE];
+      byte payLoadSize;
+      byte packetCount;
+      unsigned long pollStart = micros();
+      if (radios[r]->ReceiveGetPayloadWhenReady(payload, payLoadSize, packetCount)) {
+        radioFrames[r]++;
+        if (firstFrameMillis == 0) {
+          firstFrameMillis = millis() - bootMillis;
+        }
+        HandleReceivedPayload(r, payload, payLoadSize, packetCount);
+        radioSplitFrames[r] += HandleFollowingFrames(r, payload, payLoadSize, packetCount);
+        radios[r]->ResumeReceiver();
+      }
+      else {
+        radioPolls[r]++;
+        radioPollMicros[r] += micros() - pollStart;
+      }
+    }
+    firstRadio = (firstRadio + 1) % RADIO_COUNT;
+  }
+
+#ifdef USE_POWERSAVE
+  // Sleep until the next frame is due
+  // ---------------------------------
+  powerSave.Handle();
+  powerSave.Idle();
+#endif
+}
 
 void setup(void) {
+  bootMillis = millis();
 #ifdef USE_SX127x
   pinMode(16,OUTPUT);
-  digitalWrite(16, LOW); // set GPIO16 low to reset OLED
-  delay(50);
+  digitalWrite(16, LOW); // set GPIO16 low to reset OLED, it needs 3 us
+  delayMicroseconds(10);
   digitalWrite(16, HIGH);
 
   display.init();
@@ -500,21 +1144,20 @@ void setup(void) {
 
   Serial.begin(57600);
   while (!Serial); //if just the the basic function, must connect to a computer
-  delay(1000);
 
   Serial.print(F("\r\n[LaCrosseITPlusReader sx1278 433 57600]\r\n"));
-  Serial.println("LaCrosseITPlusReader sx1278 Receiver");
+  Serial.println(F("LaCrosseITPlusReader sx1278 Receiver"));
   display.drawString(5,5,"LaCrosseITPlusReader");
   display.display();
 #else
   Serial.begin(57600);
-  delay(200);
 #endif
   if (DEBUG) {
-    Serial.println("*** LaCrosse weather station wireless receiver for IT+ sensors ***");
+    Serial.println(F("*** LaCrosse weather station wireless receiver for IT+ sensors ***"));
   }
 
   SetDebugMode(DEBUG);
+  SensorFilter::Load();
   LaCrosse::USE_OLD_ID_CALCULATION = USE_OLD_IDS;
 
 
@@ -525,13 +1168,32 @@ void setup(void) {
 	rfm.init(); // enable use of Serial.print...
 #endif
   rfm.InitialzeLaCrosse();
-  rfm.SetFrequency(INITIAL_FREQ);
-  rfm.SetDataRate(DATA_RATE);
+#if RADIO_COUNT > 1
+  for (byte r = 1; r < RADIO_COUNT; r++) {
+    radios[r]->init();
+    radios[r]->InitialzeLaCrosse();
+  }
+#endif
   transmitter.Enable(false);
-  rfm.EnableReceiver(true);
+#if RADIO_COUNT > 1
+  // Every radio listens at its own data rate, so there is nothing to toggle
+  TOGGLE_DATA_RATE = 0;
+  DATA_RATE = RADIO_DATA_RATE[0];
+  rfm.SetDataRate(DATA_RATE);
+  for (byte r = 1; r < RADIO_COUNT; r++) {
+    radios[r]->SetDataRate(RADIO_DATA_RATE[r]);
+  }
+  SensorBase::SetOptionalFields(SensorBase::GetOptionalFields() | SensorBase::FIELD_SOURCE);
+#endif
+  // The stored configuration, or the compiled one, is applied in one pass and enables the receivers.
+  // The compiled one is taken after the radio setup, so 0w keeps the data rate of every radio.
+  CollectSettings(defaultSettings);
+  Config::Settings settings;
+  ApplySettings(Config::Load(settings) ? settings : defaultSettings);
+  rxArmedMillis = millis() - bootMillis;
 
   if (DEBUG) {
-    Serial.println("Radio setup complete. Starting to receive messages");
+    Serial.println(F("Radio setup complete. Starting to receive messages"));
   }
 
   // FHEM needs this information
@@ -1,4 +1,5 @@
 #include "LevelSenderLib.h"
+#include "WH1080.h"
 
 // Message-Format
 // --------------
@@ -32,7 +33,7 @@ void LevelSenderLib::DecodeFrame(byte *data, struct Frame *frame){
 
   frame->CRC = data[5];
   if (frame->CRC != CalculateCRC(data)) {
-    if (m_debug) { Serial.println("## CRC FAIL ##"); }
+    if (m_debug) { Serial.println(F("## CRC FAIL ##")); }
     frame->IsValid = false;
   }
 
@@ -40,7 +41,7 @@ void LevelSenderLib::DecodeFrame(byte *data, struct Frame *frame){
 
   frame->Header = (data[0] & 0xF0) >> 4;
   if (frame->Header != 11) {
-    if (m_debug) { Serial.println("No valid start"); }
+    if (m_debug) { Serial.println(F("No valid start")); }
     frame->IsValid = false;
   }
 
@@ -62,21 +63,21 @@ void LevelSenderLib::DecodeFrame(byte *data, struct Frame *frame){
   if (frame->Temperature < -40.0 || frame->Temperature > 60.0) {
     frame->IsValid = false;
     if (m_debug) {
-      Serial.print("No valid Temperature: ");
+      Serial.print(F("No valid Temperature: "));
       Serial.println(frame->Temperature);
     }
   }
   if (frame->Level < 2.0 || frame->Level > 300) {
     frame->IsValid = false;
     if (m_debug) {
-      Serial.print("No valid Level: ");
+      Serial.print(F("No valid Level: "));
       Serial.println(frame->Level);
     }
   }
   if (frame->Voltage < 2.0 || frame->Voltage > 13.0) {
     frame->IsValid = false;
     if (m_debug) {
-      Serial.print("No valid Voltage: ");
+      Serial.print(F("No valid Voltage: "));
       Serial.println(frame->Voltage);
     }
   }
@@ -120,27 +121,27 @@ bool LevelSenderLib::DisplayFrame(byte *data, struct Frame &frame, bool fOnlyIfV
 
   if (frame.IsValid) {
     // Start
-    Serial.print(" S:");
+    Serial.print(F(" S:"));
     Serial.print(frame.Header, DEC);
 
     // Sensor ID
-    Serial.print(" ID:");
+    Serial.print(F(" ID:"));
     Serial.print(frame.ID, DEC);
 
     // Level
-    Serial.print(" Level:");
+    Serial.print(F(" Level:"));
     Serial.print(frame.Level);
 
     // Temperature
-    Serial.print(" Temp:");
+    Serial.print(F(" Temp:"));
     Serial.print(frame.Temperature);
 
     // Voltage
-    Serial.print(" Volt:");
+    Serial.print(F(" Volt:"));
     Serial.print(frame.Voltage);
 
     // CRC
-    Serial.print(" CRC:");
+    Serial.print(F(" CRC:"));
     Serial.print(frame.CRC, DEC);
   }
 
@@ -202,15 +203,46 @@ String LevelSenderLib::GetFhemDataString(struct Frame *frame) {
   return result;
 }
 
+// Every digit of level, temperature and voltage is BCD
+bool LevelSenderLib::IsPlausible(byte *data) {
+  for (byte i = 1; i < FRAME_LENGTH - 1; i++) {
+    if ((data[i] >> 4) > 9 || (data[i] & 0x0F) > 9) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool LevelSenderLib::TryHandleData(byte *data, bool fFhemDisplay) {
   struct Frame frame;
+  byte corrected[FRAME_LENGTH];
   DecodeFrame(data, &frame);
+  // A WH1080 time frame starts with 0xB as well, its valid CRC makes it no damaged LevelSender frame.
+  // DecodeFrame checks the ranges of level, temperature and voltage.
+  if (!frame.IsValid && frame.Header == 11 && WH1080::CalculateCRC(data) != data[WH1080::FRAME_LENGTH - 1]
+    && CorrectFrame(data, corrected, FRAME_LENGTH)) {
+    DecodeFrame(corrected, &frame);
+    frame.IsValid = frame.IsValid && IsPlausible(corrected);
+    if (frame.IsValid) {
+      data = corrected;
+      CountCorrection();
+    }
+  }
     if (frame.IsValid) {
+      SetLastSensor(PROTOCOL_LEVELSENDER, frame.ID);
+      SetValue(VALUE_LEVEL, frame.Level);
+      SetValue(VALUE_TEMPERATURE, frame.Temperature);
+      SetValue(VALUE_VOLTAGE, frame.Voltage);
+      if (ForwardValues()) {
+        return true;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
           return fhemString.length() > 0;
   	     }
@@ -21,6 +21,7 @@ public:
   static void DecodeFrame(byte *data, struct Frame *frame);
   static void AnalyzeFrame(byte *data, bool fOnlyIfValid = false);
   static bool DisplayFrame(byte *data, struct Frame &frame, bool fOnlyIfValid = true);
+  static bool IsPlausible(byte *data);
   static bool TryHandleData(byte *data, bool fFhemDisplay = true);
   static String GetFhemDataString(struct LevelSenderLib::Frame *frame);
 
@@ -0,0 +1,273 @@
+#include "PowerSave.h"
+#include "SensorBase.h"
+#ifdef ESP32
+#include <esp_sleep.h>
+#else
+#include <avr/sleep.h>
+#endif
+
+// The sensors transmit at fixed intervals, so a receiver on battery only needs to
+// listen when a frame is due. The period of every sensor is learned from the frames,
+// once all known sensors are locked to their period the radios and the MCU sleep
+// until the next frame is due, minus a guard interval.
+// A sensor that misses several predicted frames loses the lock and the receiver
+// listens continuously again until the period is confirmed.
+
+#define POWERSAVE_GUARD           40              // ms woken before a frame is due
+#define POWERSAVE_MIN_SLEEP       100             // ms, shorter pauses are not worth the radio restart
+#define POWERSAVE_LOCK_HITS       3               // frames in a row that match the period
+#define POWERSAVE_MAX_MISSES      3               // predicted frames lost in a row until the lock is lost
+#define POWERSAVE_SENSOR_TIMEOUT  600000UL        // forget sensors not heard for 10 minutes
+
+PowerSave::PowerSave(RFMxx **radios, byte radioCount) {
+  m_radios = radios;
+  m_radioCount = radioCount;
+  m_enabled = false;
+  m_enabledMillis = 0;
+  m_sleepMillis = 0;
+  m_captured = 0;
+  m_missed = 0;
+  for (byte i = 0; i < POWERSAVE_SENSORS; i++) {
+    m_sensors[i].protocol = SensorBase::PROTOCOL_NONE;
+  }
+}
+
+void PowerSave::Enable(bool enabled) {
+  if (enabled && !m_enabled) {
+    m_enabledMillis = millis();
+    m_sleepMillis = 0;
+    m_captured = 0;
+    m_missed = 0;
+  }
+  m_enabled = enabled;
+}
+
+bool PowerSave::IsEnabled() {
+  return m_enabled;
+}
+
+PowerSave::Sensor *PowerSave::FindSensor(byte protocol, word id) {
+  unsigned long now = millis();
+  Sensor *oldest = &m_sensors[0];
+  for (byte i = 0; i < POWERSAVE_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == protocol && sensor->id == id) {
+      return sensor;
+    }
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE) {
+      oldest = sensor;
+    }
+    else if (oldest->protocol != SensorBase::PROTOCOL_NONE && now - sensor->lastSeen > now - oldest->lastSeen) {
+      oldest = sensor;
+    }
+  }
+
+  oldest->protocol = protocol;
+  oldest->id = id;
+  oldest->period = 0;
+  oldest->hits = 0;
+  oldest->misses = 0;
+  oldest->lastSeen = 0;
+  return oldest;
+}
+
+bool PowerSave::IsLocked(Sensor *sensor) {
+  return sensor->hits >= POWERSAVE_LOCK_HITS && sensor->misses < POWERSAVE_MAX_MISSES;
+}
+
+// The jitter of the transmit interval grows with the period
+unsigned long PowerSave::GetGuard(Sensor *sensor) {
+  return POWERSAVE_GUARD + sensor->period / 64;
+}
+
+void PowerSave::Update(byte protocol, word id) {
+  if (!m_enabled || protocol == SensorBase::PROTOCOL_NONE) {
+    return;
+  }
+
+  unsigned long now = millis();
+  Sensor *sensor = FindSensor(protocol, id);
+  if (sensor->lastSeen != 0) {
+    unsigned long interval = now - sensor->lastSeen;
+    if (interval < POWERSAVE_MIN_SLEEP) {
+      // A repeat of the same transmission
+      return;
+    }
+    // Every predicted slot counts once, a frame after its window was already counted as missed.
+    // Such a late frame keeps the prediction of the next slot, it would shift it by its delay.
+    long early = (long)(sensor->expected - now);
+    if (sensor->misses > 0 && m_missed > 0 && early > (long)(sensor->period / 2)) {
+      m_missed--;
+      m_captured++;
+      sensor->misses = 0;
+      return;
+    }
+    if (IsLocked(sensor)) {
+      m_captured++;
+    }
+    if (sensor->period == 0) {
+      sensor->period = interval;
+    }
+    else {
+      // Lost frames make the interval a multiple of the period
+      unsigned long periods = (interval + sensor->period / 2) / sensor->period;
+      unsigned long single = interval / (periods > 0 ? periods : 1);
+      unsigned long difference = single > sensor->period ? single - sensor->period : sensor->period - single;
+      if (difference < sensor->period / 16) {
+        sensor->period = (sensor->period * 3 + single) / 4;
+        if (sensor->hits < 255) {
+          sensor->hits++;
+        }
+      }
+      else {
+        sensor->period = interval;
+        sensor->hits = 0;
+      }
+    }
+  }
+
+  sensor->lastSeen = now;
+  sensor->expected = now + sensor->period;
+  sensor->misses = 0;
+}
+
+void PowerSave::Handle() {
+  if (!m_enabled) {
+    return;
+  }
+
+  unsigned long now = millis();
+  unsigned long sleep = 0xFFFFFFFF;
+  bool any = false;
+  bool listen = false;
+  // Every sensor is checked, the missed frames of one count while another keeps the radio on
+  for (byte i = 0; i < POWERSAVE_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE) {
+      continue;
+    }
+    if (now - sensor->lastSeen > POWERSAVE_SENSOR_TIMEOUT) {
+      sensor->protocol = SensorBase::PROTOCOL_NONE;
+      continue;
+    }
+    if (!IsLocked(sensor)) {
+      // Listen continuously until the period of every sensor is known
+      listen = true;
+      continue;
+    }
+
+    // The window of a frame that did not come is over, predict the next one
+    unsigned long guard = GetGuard(sensor);
+    while (IsLocked(sensor) && (long)(now - sensor->expected) > (long)guard) {
+      sensor->expected += sensor->period;
+      sensor->misses++;
+      m_missed++;
+    }
+
+    long remaining = (long)(sensor->expected - now) - (long)guard;
+    if (!IsLocked(sensor) || remaining <= 0) {
+      // Inside the window of this sensor
+      listen = true;
+    }
+    else if ((unsigned long)remaining < sleep) {
+      sleep = remaining;
+    }
+    any = true;
+  }
+
+  if (any && !listen && sleep >= POWERSAVE_MIN_SLEEP) {
+    Sleep(sleep);
+  }
+}
+
+// A radio in listen mode cycles between idle and RX on its own, it is left listening
+void PowerSave::Sleep(unsigned long ms) {
+  for (byte r = 0; r < m_radioCount; r++) {
+    if (!m_radios[r]->IsListening()) {
+      m_radios[r]->PowerDown();
+    }
+  }
+  Serial.flush();
+
+  unsigned long start = millis();
+#ifdef ESP32
+  // Light sleep keeps millis() running
+  esp_sleep_enable_timer_wakeup(ms * 1000ULL);
+  esp_light_sleep_start();
+#else
+  // Power down would stop timer 0 and millis(), idle is woken by its tick and by the UART
+  while (millis() - start < ms && !Serial.available()) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+  }
+#endif
+  m_sleepMillis += millis() - start;
+
+  for (byte r = 0; r < m_radioCount; r++) {
+    if (!m_radios[r]->IsListening()) {
+      m_radios[r]->EnableReceiver(true);
+    }
+  }
+}
+
+// With all radios in listen mode they wait for a frame on their own,
+// the MCU idles until the next interrupt before it polls them again
+void PowerSave::Idle() {
+#ifndef ESP32
+  for (byte r = 0; r < m_radioCount; r++) {
+    if (!m_radios[r]->IsListening()) {
+      return;
+    }
+  }
+  if (!Serial.available()) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+  }
+#endif
+}
+
+unsigned long PowerSave::GetCaptured() {
+  return m_captured;
+}
+
+unsigned long PowerSave::GetMissed() {
+  return m_missed;
+}
+
+void PowerSave::Report() {
+  unsigned long enabled = millis() - m_enabledMillis;
+  Serial.print(F("[PowerSave "));
+  Serial.print(m_enabled ? "on" : "off");
+  // Share of the time the receiver was listening
+  Serial.print(F(" Duty:"));
+  Serial.print(enabled > 0 && m_enabled ? 100.0 - m_sleepMillis * 100.0 / enabled : 100.0, 1);
+  Serial.print(F(" Sleep:"));
+  Serial.print(m_sleepMillis / 1000);
+  // Frames of locked sensors that were received, of the ones predicted
+  Serial.print(F(" Captured:"));
+  Serial.print(m_captured);
+  Serial.print(F(" Missed:"));
+  Serial.print(m_missed);
+  Serial.print(F(" Ratio:"));
+  Serial.print(m_captured + m_missed > 0 ? m_captured * 100.0 / (m_captured + m_missed) : 100.0, 1);
+  Serial.println(']');
+
+  for (byte i = 0; i < POWERSAVE_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE) {
+      continue;
+    }
+    Serial.print(F("PowerSave "));
+    Serial.print(SensorBase::GetProtocolName(sensor->protocol));
+    Serial.print(F(" ID:"));
+    Serial.print(sensor->id, DEC);
+    Serial.print(F(" Period:"));
+    Serial.print(sensor->period);
+    Serial.print(F(" Hits:"));
+    Serial.print(sensor->hits, DEC);
+    Serial.print(F(" Misses:"));
+    Serial.print(sensor->misses, DEC);
+    Serial.print(IsLocked(sensor) ? " Locked" : " Learning");
+    Serial.println();
+  }
+}
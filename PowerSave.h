@@ -0,0 +1,53 @@
+#ifndef _POWERSAVE_h
+#define _POWERSAVE_h
+
+#include "Arduino.h"
+#include "RFMxx.h"
+
+// The ATmega328 lacks the RAM for the power save, define USE_POWERSAVE to build it in anyway
+#ifdef ESP32
+#define USE_POWERSAVE
+#define POWERSAVE_SENSORS 8
+#else
+#define POWERSAVE_SENSORS 4
+#endif
+
+class PowerSave {
+ private:
+   struct Sensor {
+     byte protocol;
+     word id;
+     unsigned long lastSeen;
+     unsigned long expected;      // millis() of the next predicted frame
+     unsigned long period;        // learned transmit interval in ms
+     byte hits;                   // consecutive frames that matched the period
+     byte misses;                 // consecutive predicted frames that did not come
+   };
+
+   RFMxx **m_radios;
+   byte m_radioCount;
+   bool m_enabled;
+   Sensor m_sensors[POWERSAVE_SENSORS];
+   unsigned long m_enabledMillis;
+   unsigned long m_sleepMillis;
+   unsigned long m_captured;
+   unsigned long m_missed;
+
+   Sensor *FindSensor(byte protocol, word id);
+   bool IsLocked(Sensor *sensor);
+   unsigned long GetGuard(Sensor *sensor);
+   void Sleep(unsigned long ms);
+
+ public:
+   PowerSave(RFMxx **radios, byte radioCount);
+   void Enable(bool enabled);
+   bool IsEnabled();
+   void Update(byte protocol, word id);
+   void Handle();
+   void Idle();
+   void Report();
+   unsigned long GetCaptured();
+   unsigned long GetMissed();
+};
+
+#endif
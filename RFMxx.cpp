@@ -1,7 +1,23 @@
 #include "RFMxx.h"
 #include "SensorBase.h"
+#include "WH1080.h"
+#include "EMT7110.h"
+#include "WS1600.h"
+#include "FrameDetector.h"
 #include "JeeLink.h"
 extern JeeLink jeeLink;
+
+// Bytes read by the RFM12B interrupt, written only by the ISR and taken only by Receive
+RFMxx *RFMxx::s_ringRadio = NULL;
+volatile byte RFMxx::s_ringHead = 0;
+volatile byte RFMxx::s_ringTail = 0;
+volatile byte RFMxx::s_ringOverflows = 0;
+volatile byte RFMxx::s_ringData[RING_SIZE];
+volatile word RFMxx::s_ringTicks[RING_SIZE];
+volatile int8_t RFMxx::s_ringOffset[RING_SIZE];
+byte RFMxx::s_isrFrame[FrameDetector::UNKNOWN_MAX_LENGTH];
+byte RFMxx::s_isrLength = 0;
+byte RFMxx::s_isrCrc = 0;
 #ifdef USE_SPI_H
 #include <SPI.h>
 #define m_miso MISO
@@ -13,19 +29,63 @@ extern JeeLink jeeLink;
 
 void RFMxx::Receive() {
   if (IsRF69 || IsSX127x) {
-    if (ReadReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY) {
+    // IRQFLAGS1 and IRQFLAGS2 are adjacent, one burst gives sync match and payload ready
+    byte flags[2];
+    ReadBurst(REG_IRQFLAGS1, flags, 2);
+    m_spiPolls++;
+    if (!m_signalSampled && (flags[0] & RF_IRQFLAGS1_SYNCADDRESSMATCH)) {
+      SampleSignal();
+      m_syncMicros = micros();
+      m_syncCount++;
+    }
+#ifdef _RFM69_h
+    if (m_listen && (flags[0] & RF_IRQFLAGS1_TIMEOUT)) {
+      // The RSSI woke the listen mode but no payload followed, the radio stopped in standby
+      m_listenTimeouts++;
+      m_signalSampled = false;
+      StartListen();
+      ClearFifo();
+      return;
+    }
+#endif
+    if (m_receiveMode & RX_STREAMING) {
+      // Cut-through: take the bytes while the frame is still on air
+      while (FifoHasData(flags[1]) && !m_payloadReady) {
+        StreamByte(ReadReg(REG_FIFO));
+        flags[1] = ReadReg(REG_IRQFLAGS2);
+      }
+    }
+    else if (flags[1] & RF_IRQFLAGS2_PAYLOADREADY) {
+      // The packet engine holds the payload and does not listen until it is restarted
+      MarkBlind();
       m_lastReceiveTime = millis();
+      ReadSignal();
+      if (m_listen) {
+        m_listenFrames++;
+      }
 	  m_payloadPointer = 0;
-      for (int i = 0; i < PAYLOADSIZE; i++) {
-        byte bt = GetByteFromFifo();
+      Select();
+      Transfer(REG_FIFO & 0x7F);
+      for (int i = 0; i < m_payloadLength; i++) {
+        byte bt = Transfer(0);
         m_payload_crc = SensorBase::UpdateCRC(m_payload_crc, bt);
         m_payload[i] = bt;
-		m_payloadPointer = i;
-        if (m_payloadPointer >= m_payload_min_size && m_payload_crc == 0) {
+		m_payloadPointer = i + 1;
+        // In length aware mode the FIFO is drained completely, so the radio restarts at once
+        if (m_payloadPointer > m_payload_min_size && m_payload_crc == 0 && !(m_receiveMode & RX_LENGTH_AWARE)) {
 			break;
 		}
       }
-      m_payloadReady = true;
+      Deselect();
+      if (m_receiveMode & RX_LENGTH_AWARE) {
+        RestartReceiver();
+      }
+      else if (m_receiveMode & RX_FAST_RESTART) {
+        // The rest of the fixed length payload is dropped
+        RestartReceiver();
+        ClearFifo();
+      }
+      SetPayloadReady();
     }
   }
   else {
@@ -48,19 +108,56 @@ void RFMxx::Receive() {
 #define RF_OVF_BIT      0x2000
 #define RF_RSSI_BIT     0x0100
 
+    if (s_ringRadio == this) {
+      ReceiveFromRing();
+      return;
+    }
+
 	// try
 	bool hasData = digitalRead(m_irqPin) == 0;
+	unsigned short status;
+	m_spiPolls++;
 //	while ((digitalRead(m_irqPin) == 0) && !m_payloadReady) {{
-	while ((spi16(0) & RF_FIFO_BIT) && !m_payloadReady) {{
+	while (((status = spi16(0)) & RF_FIFO_BIT) && !m_payloadReady) {{
 #endif
+        if (m_payloadPointer == 0) {
+          // RFM12B has no RSSI value, only the AFC offset in the status word (5 kHz steps)
+          int8_t offset = status & 0x1F;
+          if (offset & 0x10) {
+            offset -= 0x20;
+          }
+          m_rssi = 0;
+          m_fei = offset * 5000L;
+          m_signalSampled = true;
+          // No sync interrupt on the RFM12B, the first byte is the earliest sign of a frame
+          m_syncMicros = micros();
+        }
         byte bt = GetByteFromFifo();
+        if (m_receiveMode & RX_STREAMING) {
+          StreamByte(bt);
+          continue;
+        }
       m_payload[m_payloadPointer++] = bt;
       m_lastReceiveTime = millis();
       m_payload_crc = SensorBase::UpdateCRC(m_payload_crc, bt);
     }
 
-    if ((m_payloadPointer >= 8 && m_payload_crc == 0) || (m_payloadPointer > 0 && millis() > m_lastReceiveTime + 50) || m_payloadPointer >= 32) {
-      m_payloadReady = true;
+    if (m_payloadReady) {
+      // StreamByte completed the frame
+      return;
+    }
+    if ((m_receiveMode & RX_LENGTH_AWARE) && m_payloadPointer >= m_payloadLength) {
+      // Hunt for the next sync word right away
+      MarkBlind();
+      RestartReceiver();
+      SetPayloadReady();
+    }
+    else if ((m_payloadPointer >= 8 && m_payload_crc == 0) || (m_payloadPointer > 0 && millis() > m_lastReceiveTime + 50) || m_payloadPointer >= 32) {
+      MarkBlind();
+      if (m_receiveMode & RX_FAST_RESTART) {
+        RestartReceiver();
+      }
+      SetPayloadReady();
     }
   }
 #if 1
@@ -68,9 +165,211 @@ void RFMxx::Receive() {
 #endif
 }
 
+// nIRQ of the RFM12B: store the FIFO byte with a timestamp of 16 us ticks. The sync
+// pattern recognition is re-armed as soon as the bytes form a frame, so the next frame
+// starts after a gap of at least its preamble.
+void RFMxx::HandleInterrupt() {
+  RFMxx *radio = s_ringRadio;
+  // The transfers of the interrupt are not counted, an increment of the main loop
+  // that the interrupt splits keeps its value
+  unsigned long transactions = radio->m_spiTransactions;
+  unsigned short status = radio->spi16(0);
+  if (!(status & RF_FIFO_BIT)) {
+    radio->m_spiTransactions = transactions;
+    return;
+  }
+  byte bt = radio->spi16(0xB000);
+  byte next = (s_ringHead + 1) % RING_SIZE;
+  if (next == s_ringTail) {
+    s_ringOverflows++;
+  }
+  else {
+    s_ringData[s_ringHead] = bt;
+    s_ringTicks[s_ringHead] = micros() >> 4;
+    if (s_isrLength == 0) {
+      // AFC offset in 5 kHz steps
+      int8_t offset = status & 0x1F;
+      s_ringOffset[s_ringHead] = offset & 0x10 ? offset - 0x20 : offset;
+    }
+    s_ringHead = next;
+  }
+
+  s_isrFrame[s_isrLength++] = bt;
+  s_isrCrc = SensorBase::UpdateCRC(s_isrCrc, bt);
+  if (FrameDetector::IsComplete(s_isrFrame, s_isrLength, s_isrCrc)
+    || s_isrLength >= FrameDetector::GetMaxLength(s_isrFrame, s_isrLength)) {
+    radio->spi16(0xCA81);
+    radio->spi16(0xCA83);
+    s_isrLength = 0;
+    s_isrCrc = 0;
+  }
+  radio->m_spiTransactions = transactions;
+}
+
+// Take the bytes of the interrupt ring. A frame ends when a protocol recognises it
+// or at a gap of more than three byte times.
+void RFMxx::ReceiveFromRing() {
+  word gapTicks = 1500000UL / m_dataRate;
+  while (s_ringTail != s_ringHead && !m_payloadReady) {
+    byte tail = s_ringTail;
+    word ticks = s_ringTicks[tail];
+    if (m_payloadPointer > 0 && (word)(ticks - m_lastTicks) > gapTicks) {
+      // This byte starts the next frame
+      SetPayloadReady();
+      break;
+    }
+    if (m_payloadPointer == 0) {
+      m_syncMicros = micros() - ((unsigned long)(word)((micros() >> 4) - ticks) << 4);
+      m_rssi = 0;
+      m_fei = s_ringOffset[tail] * 5000L;
+      m_signalSampled = true;
+    }
+    byte bt = s_ringData[tail];
+    s_ringTail = (tail + 1) % RING_SIZE;
+    m_payload[m_payloadPointer++] = bt;
+    m_lastTicks = ticks;
+    m_lastReceiveTime = millis();
+    m_payload_crc = SensorBase::UpdateCRC(m_payload_crc, bt);
+    if (FrameDetector::IsComplete(m_payload, m_payloadPointer, m_payload_crc) || m_payloadPointer >= 32) {
+      SetPayloadReady();
+    }
+  }
+  if (!m_payloadReady && m_payloadPointer > 0 && s_ringTail == s_ringHead && (word)((micros() >> 4) - m_lastTicks) > gapTicks) {
+    SetPayloadReady();
+  }
+}
+
+// Only the RFM12B has a FIFO interrupt worth serving, RFM69 and SX127x have their own FIFO
+void RFMxx::EnableInterruptRing(bool enable) {
+  if (IsRF69 || IsSX127x) {
+    return;
+  }
+#ifdef USE_SPI_H
+  byte interrupt = digitalPinToInterrupt(m_irqPin);
+#else
+  byte interrupt = digitalPinToInterrupt(m_irq);
+#endif
+  if (enable && s_ringRadio == NULL) {
+    s_ringHead = 0;
+    s_ringTail = 0;
+    s_isrLength = 0;
+    s_isrCrc = 0;
+    s_ringRadio = this;
+#ifdef USE_SPI_H
+    // Every SPI transaction of the sketch masks the interrupt
+    SPI.usingInterrupt(interrupt);
+#endif
+    attachInterrupt(interrupt, HandleInterrupt, LOW);
+  }
+  else if (!enable && s_ringRadio == this) {
+    detachInterrupt(interrupt);
+#ifdef USE_SPI_H
+    SPI.notUsingInterrupt(interrupt);
+#endif
+    s_ringRadio = NULL;
+  }
+}
+
+byte RFMxx::GetRingOverflows() {
+  return s_ringOverflows;
+}
+
+// Append a byte of a frame that is still on air. The frame is complete as soon as a
+// protocol recognises it or when no protocol can complete it anymore, the receiver
+// then hunts for the next sync word while the rest of the air time is ignored.
+void RFMxx::StreamByte(byte bt) {
+  m_payload[m_payloadPointer++] = bt;
+  m_lastReceiveTime = millis();
+  m_payload_crc = SensorBase::UpdateCRC(m_payload_crc, bt);
+  if (FrameDetector::IsComplete(m_payload, m_payloadPointer, m_payload_crc)
+    || m_payloadPointer >= FrameDetector::GetMaxLength(m_payload, m_payloadPointer)
+    || m_payloadPointer >= m_payloadLength) {
+    MarkBlind();
+    if (IsRF69 || IsSX127x) {
+      ReadSignal();
+      RestartReceiver();
+      ClearFifo();
+    }
+    else {
+      RestartReceiver();
+    }
+    SetPayloadReady();
+  }
+}
+
+// Time from sync word to a payload the sketch can take
+void RFMxx::SetPayloadReady() {
+  unsigned long latency = micros() - m_syncMicros;
+  m_payloadReady = true;
+  m_frameTransactionStart = m_spiTransactions - m_spiPolls;
+  if (m_latencyCount == 0xFFFF) {
+    // Halved the mean stays, the sum cannot overflow
+    m_latencySum /= 2;
+    m_latencyCount /= 2;
+  }
+  m_latencySum += latency;
+  m_latencyCount++;
+  if (latency > m_latencyMax) {
+    m_latencyMax = latency;
+  }
+}
+
+unsigned long RFMxx::GetLatency() {
+  return m_latencyCount ? m_latencySum / m_latencyCount : 0;
+}
+
+unsigned long RFMxx::GetLatencyMax() {
+  return m_latencyMax;
+}
+
+void RFMxx::ResetLatency() {
+  m_latencySum = 0;
+  m_latencyCount = 0;
+  m_latencyMax = 0;
+}
+
+// The receiver stops listening: a payload is complete or RX is left
+void RFMxx::MarkBlind() {
+  if (!m_blind) {
+    m_blind = true;
+    m_blindSince = micros();
+  }
+}
+
+// The receiver hunts for a sync word again
+void RFMxx::MarkListening() {
+  if (m_blind) {
+    m_blind = false;
+    m_blindMicros += micros() - m_blindSince;
+    m_blindCount++;
+    // Keep the sum in milliseconds, micros() would overflow after 71 minutes
+    m_blindMillis += m_blindMicros / 1000;
+    m_blindMicros %= 1000;
+  }
+}
+
+// Total time the receiver was not listening
+unsigned long RFMxx::GetBlindMillis() {
+  return m_blindMillis;
+}
+
+// Number of times the receiver was not listening, about one per frame
+unsigned long RFMxx::GetBlindCount() {
+  return m_blindCount;
+}
+
+bool RFMxx::RestartsAtOnce() {
+  // The listen mode ends in standby after each payload
+  if (m_listen) {
+    return false;
+  }
+  return (m_receiveMode & (RX_LENGTH_AWARE | RX_STREAMING | RX_FAST_RESTART)) || s_ringRadio == this;
+}
+
 byte RFMxx::GetPayload(byte *data) {
 	byte payloadPointer = m_payloadPointer;
   m_payloadReady = false;
+  m_signalSampled = false;
   m_payloadPointer = 0;
   m_payload_crc = 0;
   for (int i = 0; i < PAYLOADSIZE; i++) {
@@ -79,71 +378,248 @@ byte RFMxx::GetPayload(byte *data) {
   return payloadPointer;
 }
 
+// Repeats of a payload (WH1080 sends 6) are collected over several calls, so the loop keeps
+// running meanwhile. Every candidate counts its identical copies and is handed over when no
+// copy came for 50 ms or after 8 copies. A payload of 16 bytes or more is handed over at once.
 bool RFMxx::ReceiveGetPayloadWhenReady(byte *data, byte &length, byte &packetCount) {
-      byte payload[PAYLOADSIZE];
-      byte payLoadSize;
-//      byte packetCount;
-	bool fAgain = false;
-	bool fEnableReceiver = true;
-	unsigned long lastReceiveTime = 0;
-	byte count = 0;
-	byte len;
-	bool fPayloadIsReady = false;
+  bool released = false;
 
-	do {
-		Receive();
+  Receive();
+  if (PayloadIsReady()) {
+    byte payload[PAYLOADSIZE];
+    byte payLoadSize = GetPayload(payload);
+    RepeatCandidate *candidate = NULL;
+    if (payLoadSize < REPEAT_FRAME_SIZE) {
+      candidate = FindRepeat(payload, payLoadSize);
+    }
+    if (candidate != NULL) {
+      candidate->count++;
+      candidate->lastSeen = millis();
+      m_repeatsMerged++;
+    }
+    else if (payLoadSize >= REPEAT_FRAME_SIZE) {
+      for (byte i = 0; i < payLoadSize; i++) {
+        data[i] = payload[i];
+      }
+      length = payLoadSize;
+      packetCount = 1;
+      m_payloadRssi = m_rssi;
+      m_payloadFei = m_fei;
+      released = true;
+    }
+    else {
+      // A new candidate, when all are taken the oldest one is handed over now
+      unsigned long now = millis();
+      candidate = &m_repeats[0];
+      for (byte i = 0; i < REPEAT_CANDIDATES; i++) {
+        if (m_repeats[i].count == 0) {
+          candidate = &m_repeats[i];
+          break;
+        }
+        if (now - m_repeats[i].lastSeen > now - candidate->lastSeen) {
+          candidate = &m_repeats[i];
+        }
+      }
+      if (candidate->count > 0) {
+        ReleaseRepeat(candidate, data, length, packetCount);
+        released = true;
+        m_repeatsEvicted++;
+      }
+      memcpy(candidate->data, payload, payLoadSize);
+      candidate->length = payLoadSize;
+      candidate->count = 1;
+      candidate->rssi = m_rssi;
+      candidate->fei = m_fei;
+      candidate->lastSeen = millis();
+    }
+    if (HasPendingRepeats() && !RestartsAtOnce()) {
+      // Listen for the next copy
+      EnableReceiver(true, false);
+    }
+  }
 
-		if (PayloadIsReady()) {
-			payLoadSize = GetPayload(payload);
-			if (!fPayloadIsReady) {
-				  for (int i = 0; i < payLoadSize; i++) {
-					data[i] = payload[i];
-				  }
-				length = payLoadSize;
-				len = payLoadSize;
-				count++;
-				fPayloadIsReady = true;
-				fAgain = (payLoadSize < 16);
-			}
-			else if (payLoadSize >= len) { // WH1080 sends 6 repeated packages
-				int i;
-				  for (i = 0; i < len; i++) {
-					if (data[i] != payload[i]) {
-						break;
-					}
-				  }
-				  if (i >= len) {
-					count++; // matching packet count
-					fAgain = true;
-				  }
-			}
-			else {
-				fAgain = false;
-			}
-			packetCount = count;
+  for (byte i = 0; i < REPEAT_CANDIDATES && !released; i++) {
+    RepeatCandidate *candidate = &m_repeats[i];
+    if (candidate->count > 0 && (candidate->count >= 8 || millis() - candidate->lastSeen > 50)) {
+      ReleaseRepeat(candidate, data, length, packetCount);
+      released = true;
+    }
+  }
 
-			if (fAgain) {
-				lastReceiveTime = millis();
-				fEnableReceiver = true;
-				EnableReceiver(fEnableReceiver, false);
-			}
-	  }
-	  else {
-		  fAgain = fAgain && (fPayloadIsReady) && (count < 8) && (millis() < lastReceiveTime + 50);
-	  }
-	} while (fAgain);
+  if (released && !HasPendingRepeats() && !RestartsAtOnce()) {
+    EnableReceiver(false);
+  }
+  return released;
+}
 
-	if (fEnableReceiver && fPayloadIsReady) {
-		fEnableReceiver = false;
-		EnableReceiver(fEnableReceiver);
-	}
-	return (fPayloadIsReady);
+RFMxx::RepeatCandidate *RFMxx::FindRepeat(byte *payload, byte payLoadSize) {
+  for (byte i = 0; i < REPEAT_CANDIDATES; i++) {
+    RepeatCandidate *candidate = &m_repeats[i];
+    if (candidate->count > 0 && payLoadSize >= candidate->length && memcmp(candidate->data, payload, candidate->length) == 0) {
+      return candidate;
+    }
+  }
+  return NULL;
+}
+
+void RFMxx::ReleaseRepeat(RepeatCandidate *candidate, byte *data, byte &length, byte &packetCount) {
+  memcpy(data, candidate->data, candidate->length);
+  length = candidate->length;
+  packetCount = candidate->count;
+  m_payloadRssi = candidate->rssi;
+  m_payloadFei = candidate->fei;
+  candidate->count = 0;
+}
+
+bool RFMxx::HasPendingRepeats() {
+  for (byte i = 0; i < REPEAT_CANDIDATES; i++) {
+    if (m_repeats[i].count > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Signal strength and frequency error are latched at sync address match, while the
+// transmitter is still on air. FEI on the RFM69 has to be started, the SX127x updates it itself.
+void RFMxx::SampleSignal() {
+  m_rssi = -(int)(ReadReg(REG_RSSIVALUE) >> 1);
+#ifdef _RFM69_h
+  WriteReg(REG_AFCFEI, RF_AFCFEI_FEI_START);
+#endif
+  m_signalSampled = true;
+}
+
+// Read FEI (and RSSI if the sync match was missed) just before the FIFO
+void RFMxx::ReadSignal() {
+  byte regs[4];
+#ifdef _RFM69_h
+  // FEIMSB, FEILSB, RSSICONFIG, RSSIVALUE
+  ReadBurst(REG_FEIMSB, regs, 4);
+  if (!m_signalSampled) {
+    m_rssi = -(int)(regs[3] >> 1);
+  }
+#else
+  ReadBurst(REG_FEIMSB, regs, 2);
+  if (!m_signalSampled) {
+    m_rssi = -(int)(ReadReg(REG_RSSIVALUE) >> 1);
+  }
+#endif
+  // FEI is in steps of FSTEP = 32 MHz / 2^19 = 61.035 Hz
+  m_fei = (long)(int16_t)((regs[0] << 8) | regs[1]) * 61035L / 1000L;
+  m_signalSampled = true;
+}
+
+int RFMxx::GetRssi() {
+  return m_payloadRssi;
+}
+
+long RFMxx::GetFei() {
+  return m_payloadFei;
 }
 
+// RSSI in dBm at the frequency the receiver is tuned to, the RFM12B has no RSSI value
+int RFMxx::MeasureRssi() {
+#ifdef _RFM69_h
+  if (IsRF69) {
+    WriteReg(REG_RSSICONFIG, RF_RSSI_START);
+    for (byte i = 0; i < 100 && !(ReadReg(REG_RSSICONFIG) & RF_RSSI_DONE); i++);
+  }
+#endif
+  return -(int)(ReadReg(REG_RSSIVALUE) >> 1);
+}
+
+// Sync words seen by RFM69 and SX127x, with or without a valid frame
+unsigned long RFMxx::GetSyncCount() {
+  return m_syncCount;
+}
+
+// Register values of the data rates, computed by the compiler. Bitrate and deviation
+// as well as RX and AFC bandwidth are adjacent registers on RFM69 and SX127x.
+#define BITRATE_REG(dataRate) ((32000000UL + (dataRate) / 2) / (dataRate))
+#define FDEV_REG(hz) (((hz) * 1000UL + 30517UL) / 61035UL)
+#ifdef _RFM69_h
+#define RXBW_DCC RF_RXBW_DCCFREQ_010
+#else
+#define RXBW_DCC 0
+#endif
+#define PROFILE_RATE(dataRate, deviation) \
+  { BITRATE_REG(dataRate) >> 8, BITRATE_REG(dataRate) & 0xFF, FDEV_REG(deviation) >> 8, FDEV_REG(deviation) & 0xFF }
+
+struct RadioProfile {
+  unsigned long dataRate;
+  byte rate[4];          // REG_BITRATEMSB, REG_BITRATELSB, REG_FDEVMSB, REG_FDEVLSB
+  byte bandwidth[2];     // REG_RXBW, REG_AFCBW
+  word bandwidthKHz;
+  byte rfm12Rate;        // RFM12B data rate command 0xC6xx
+  byte payloadLength;    // longest frame at this data rate
+  byte listenRx;         // RFM69 listen mode RX and idle phase in 64 us units
+  byte listenIdle;
+};
+
+// RFM69 listen mode: the RX phase covers the start of crystal and PLL plus two bit times
+// for the RSSI. The idle phase is chosen so that a whole RX phase always falls into the
+// 40 bit preamble, the next one at the latest.
+#define LISTEN_STARTUP 410
+#define LISTEN_RX(dataRate) ((LISTEN_STARTUP + 2 * 1000000UL / (dataRate) + 63) / 64)
+#define LISTEN_IDLE(dataRate) ((40 * 1000000UL / (dataRate) - 2 * 64 * LISTEN_RX(dataRate)) / 64)
+#define PROFILE_LISTEN(dataRate) LISTEN_RX(dataRate), LISTEN_IDLE(dataRate)
+
+static const RadioProfile profiles[RFMxx::PROFILE_COUNT] PROGMEM = {
+  // LaCrosse 5, TX38IT 4, LevelSender 6, WH1080 9 or 10 bytes
+  { 17241, PROFILE_RATE(17241, 90000), { RXBW_DCC | RF_RXBW_MANT_16 | RF_RXBW_EXP_2, RXBW_DCC | RF_RXBW_MANT_24 | RF_RXBW_EXP_1 }, 125, 0x13, WH1080::FRAME_LENGTH, PROFILE_LISTEN(17241) },
+  // EMT7110 and the slow LaCrosse sensors
+  { 9579, PROFILE_RATE(9579, 90000), { RXBW_DCC | RF_RXBW_MANT_20 | RF_RXBW_EXP_2, RXBW_DCC | RF_RXBW_MANT_16 | RF_RXBW_EXP_2 }, 100, 0x23, EMT7110::FRAME_LENGTH, PROFILE_LISTEN(9579) },
+  // WS1600 with up to 5 quartets, see http://www.g-romahn.de/ws1600
+  { 8621, PROFILE_RATE(8621, 90000), { RXBW_DCC | RF_RXBW_MANT_20 | RF_RXBW_EXP_2, RXBW_DCC | RF_RXBW_MANT_16 | RF_RXBW_EXP_2 }, 100, 0x28, WS1600::FRAME_LENGTH, PROFILE_LISTEN(8621) }
+};
+
+// Switch to a data rate with one burst for bitrate and deviation and one for the bandwidths
+void RFMxx::SetProfile(byte index) {
+  if (index >= PROFILE_COUNT) {
+    return;
+  }
+  unsigned long start = micros();
+  RadioProfile profile;
+  memcpy_P(&profile, &profiles[index], sizeof(RadioProfile));
+  m_profile = index;
+  m_dataRate = profile.dataRate;
+  m_payload_max_size = 64;
+  m_payload_min_size = (m_dataRate == 17241) ? 10 : 8;
+  SetReceiveMode(m_receiveMode);
+
+  if (IsRF69 || IsSX127x) {
+    WriteBurst(REG_BITRATEMSB, profile.rate, sizeof(profile.rate));
+    WriteBurst(REG_RXBW, profile.bandwidth, sizeof(profile.bandwidth));
+    m_bandwidth = profile.bandwidthKHz;
+  }
+  else {
+    RFMxx::spi16(0xC600 | profile.rfm12Rate);
+  }
+  m_profileSwitchMicros = micros() - start;
+}
+
+byte RFMxx::GetProfile() {
+  return m_profile;
+}
+
+unsigned long RFMxx::GetProfileSwitchMicros() {
+  return m_profileSwitchMicros;
+}
+
 void RFMxx::SetDataRate(unsigned long dataRate) {
+  for (byte i = 0; i < PROFILE_COUNT; i++) {
+    if (pgm_read_dword(&profiles[i].dataRate) == dataRate) {
+      SetProfile(i);
+      return;
+    }
+  }
+
+  m_profile = PROFILE_COUNT;
   m_dataRate = dataRate;
   m_payload_max_size = 64;
   m_payload_min_size = (m_dataRate == 17241) ? 10 : 8;
+  SetReceiveMode(m_receiveMode);
 
   if (IsRF69 || IsSX127x) {
     word r = ((32000000UL + (m_dataRate / 2)) / m_dataRate);
@@ -173,19 +649,78 @@ void RFMxx::SetFrequency(unsigned long kHz) {
 
   if (IsRF69 || IsSX127x) {
     unsigned long f = (((kHz * 1000) << 2) / (32000000L >> 11)) << 6;
-    WriteReg(REG_FRFMSB, f >> 16);
-    WriteReg(REG_FRFMID, f >> 8);
-    WriteReg(REG_FRFLSB, f);
+    // One burst, the new frequency takes effect with the LSB
+    byte frf[3] = { (byte)(f >> 16), (byte)(f >> 8), (byte)f };
+    WriteBurst(REG_FRFMSB, frf, sizeof(frf));
   }
   else {
     RFMxx::spi16(40960 + (m_frequency - 860000) / 5);
   }
 }
 
+// The narrowest available receiver bandwidth that is at least kHz wide and its register bits
+word RFMxx::RoundBandwidth(word kHz, byte *bits) {
+  if (IsRF69 || IsSX127x) {
+    // RxBw = FXOSC / (mant * 2^(exp + 2)), mant 16, 20 or 24
+    byte mants[] = { 24, 20, 16 };
+    byte mantBits[] = { RF_RXBW_MANT_24, RF_RXBW_MANT_20, RF_RXBW_MANT_16 };
+    byte value = RF_RXBW_MANT_16 | RF_RXBW_EXP_0;
+    word bw = 32000 / (16 << 2);
+    for (int8_t e = 7; e >= 0; e--) {
+      for (byte m = 0; m < 3; m++) {
+        word b = 32000UL / ((unsigned long)mants[m] << (e + 2));
+        if (b >= kHz) {
+          value = mantBits[m] | e;
+          bw = b;
+          e = -1;
+          break;
+        }
+      }
+    }
+    if (bits != NULL) {
+      *bits = value;
+    }
+    return bw;
+  }
+  // Receiver control 0x94xx, BW bits 7..5: 110=67, 101=134, 100=200, 011=270, 010=340, 001=400 kHz
+  word bws[] = { 67, 134, 200, 270, 340, 400 };
+  byte i = 0;
+  while (i < 5 && bws[i] < kHz) {
+    i++;
+  }
+  if (bits != NULL) {
+    *bits = 6 - i;
+  }
+  return bws[i];
+}
+
+void RFMxx::SetBandwidth(word kHz) {
+  byte bits;
+  m_bandwidth = RoundBandwidth(kHz, &bits);
+  if (IsRF69 || IsSX127x) {
+#ifdef _RFM69_h
+    bits |= RF_RXBW_DCCFREQ_010;
+#endif
+    WriteReg(REG_RXBW, bits);
+  }
+  else {
+    spi16(0x9400 | (bits << 5));
+  }
+}
+
+word RFMxx::GetBandwidth() {
+  return m_bandwidth;
+}
+
 void RFMxx::EnableReceiver(bool enable, bool fClearFifo){
+  // Mode changes and clearing the FIFO are blind time as well
+  MarkBlind();
   if (enable) {
-    if (IsRF69 || IsSX127x) {
-      WriteReg(REG_OPMODE, (ReadReg(REG_OPMODE) & RF_OPMODE_MASK) | RF_OPMODE_RECEIVER);
+    if (m_listen) {
+      StartListen();
+    }
+    else if (IsRF69 || IsSX127x) {
+      SetOpMode(RF_OPMODE_RECEIVER);
     }
     else {
       spi16(0x82C8);
@@ -195,29 +730,290 @@ void RFMxx::EnableReceiver(bool enable, bool fClearFifo){
   }
   else {
     if (IsRF69 || IsSX127x) {
-      WriteReg(REG_OPMODE, (ReadReg(REG_OPMODE) & RF_OPMODE_MASK) | RF_OPMODE_STANDBY);
+      SetOpMode(RF_OPMODE_STANDBY);
     }
     else {
+      EnableInterruptRing(false);
       spi16(0x8208);
     }
   }
   if (fClearFifo /* || IsRF69 */) {
   	ClearFifo();
  }
+  if (enable) {
+    // Back after a transmission or power down, once the FIFO is cleared
+    EnableInterruptRing(m_receiveMode & RX_IRQ_RING);
+    MarkListening();
+  }
+}
+
+// Program the payload length of the longest frame expected at the current data rate.
+// In fixed length mode the radio collects PAYLOADSIZE bytes, about 30 ms at 17241 bps,
+// and a frame following within that time is lost.
+void RFMxx::SetReceiveMode(byte mode) {
+  m_receiveMode = mode;
+  m_payloadLength = PAYLOADSIZE;
+  if ((m_receiveMode & RX_LENGTH_AWARE) && m_profile < PROFILE_COUNT) {
+    m_payloadLength = pgm_read_byte(&profiles[m_profile].payloadLength);
+  }
+  if (IsRF69 || IsSX127x) {
+    WriteReg(REG_PAYLOADLENGTH, m_payloadLength);
+  }
+  if (m_listen) {
+    // The timeout follows the payload length, the RX phase the data rate
+    WriteListenTiming();
+  }
+  EnableInterruptRing(m_receiveMode & RX_IRQ_RING);
+}
+
+byte RFMxx::GetReceiveMode() {
+  return m_receiveMode;
+}
+
+// Restart the packet engine without leaving RX
+// After a frequency change the SX127x has to lock its PLL again, pllLock waits for that
+void RFMxx::RestartReceiver(bool pllLock) {
+  if (IsRF69) {
+#ifdef _RFM69_h
+    WriteReg(REG_PACKETCONFIG2, RF_PACKET2_RXRESTARTDELAY_2BITS | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF | RF_PACKET2_RXRESTART);
+#endif
+  }
+  else if (IsSX127x) {
+#ifdef USE_SX127x
+    WriteReg(REG_RXCONFIG, RF_RXCONFIG_AGCAUTO_ON | RF_RXCONFIG_RXTRIGER_PREAMBLEDETECT | (pllLock ? RF_RXCONFIG_RESTARTRXWITHPLLLOCK : RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK));
+#endif
+  }
+  else {
+    // Re-arm the sync pattern recognition of the FIFO
+    spi16(0xCA81);
+    spi16(0xCA83);
+  }
+  MarkListening();
+}
+
+// Called after a payload was handled
+void RFMxx::ResumeReceiver() {
+  // With copies still being collected the receiver was left on
+  if (!RestartsAtOnce() && !HasPendingRepeats()) {
+    EnableReceiver(true);
+  }
+  // SPI traffic of the frame without the polls while waiting for it
+  m_frameTransactionSum += m_spiTransactions - m_spiPolls - m_frameTransactionStart;
+  m_frameTransactionCount++;
+}
+
+// Mode changes are single writes, the other OPMODE bits come from the shadow
+void RFMxx::SetOpMode(byte mode) {
+#ifdef _RFM69_h
+  if (m_shadow[REG_OPMODE] & RF_OPMODE_LISTEN_ON) {
+    // Listen mode is left with ListenAbort and the new mode in one write, then the mode alone
+    WriteReg(REG_OPMODE, (m_shadow[REG_OPMODE] & RF_OPMODE_MASK & ~RF_OPMODE_LISTEN_ON) | RF_OPMODE_LISTENABORT | mode);
+  }
+#endif
+  WriteReg(REG_OPMODE, (m_shadow[REG_OPMODE] & RF_OPMODE_MASK) | mode);
+}
+
+// RFM69 listen mode: the radio itself alternates between an idle phase on the RC oscillator
+// and a short RX phase. A signal above the RSSI threshold keeps it in RX until the payload
+// is ready or the RX timeout ends it, then it stops in standby with the payload in the FIFO.
+// Without a signal the receiver draws about RX current times the share of the RX phase.
+bool RFMxx::EnableListen(bool enable) {
+  if (!IsRF69) {
+    return false;
+  }
+#ifdef _RFM69_h
+  if (enable == m_listen) {
+    return true;
+  }
+  bool receiving = (m_shadow[REG_OPMODE] & RF_OPMODE_LISTEN_ON) || (m_shadow[REG_OPMODE] & ~RF_OPMODE_MASK) == RF_OPMODE_RECEIVER;
+  if (enable) {
+    m_listen = true;
+    m_listenFrames = 0;
+    m_listenTimeouts = 0;
+    WriteListenTiming();
+  }
+  else {
+    m_listen = false;
+    SetOpMode(RF_OPMODE_STANDBY);
+    WriteReg(REG_RXTIMEOUT2, 0);
+    WriteReg(REG_RSSITHRESH, 220);
+  }
+  if (receiving) {
+    EnableReceiver(true);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Idle and RX phase in 64 us units, 0 takes them from the data rate profile, rssi in -dBm
+void RFMxx::SetListenTiming(byte idle, byte rx, byte rssi) {
+  m_listenIdle = idle;
+  m_listenRx = rx;
+  if (rssi > 0) {
+    // RSSITHRESH holds twice the value, -127 dBm is the weakest threshold
+    m_listenRssi = rssi > 127 ? 127 : rssi;
+  }
+#ifdef _RFM69_h
+  if (m_listen) {
+    WriteListenTiming();
+    if (m_shadow[REG_OPMODE] & RF_OPMODE_LISTEN_ON) {
+      StartListen();
+    }
+  }
+#endif
+}
+
+bool RFMxx::IsListening() {
+  return m_listen;
+}
+
+// In continuous RX, a new frequency or bandwidth takes effect only after RestartReceiver(true).
+// The RFM12B takes them at once and keeps no mode to tell.
+bool RFMxx::IsReceiving() {
+  if (IsRF69 || IsSX127x) {
+    return !m_listen && (m_shadow[REG_OPMODE] & ~RF_OPMODE_MASK) == RF_OPMODE_RECEIVER;
+  }
+  return false;
+}
+
+byte RFMxx::GetListenIdle() {
+  if (m_listenIdle > 0) {
+    return m_listenIdle;
+  }
+  if (m_profile < PROFILE_COUNT) {
+    return pgm_read_byte(&profiles[m_profile].listenIdle);
+  }
+  return LISTEN_IDLE(m_dataRate);
+}
+
+byte RFMxx::GetListenRx() {
+  if (m_listenRx > 0) {
+    return m_listenRx;
+  }
+  if (m_profile < PROFILE_COUNT) {
+    return pgm_read_byte(&profiles[m_profile].listenRx);
+  }
+  return LISTEN_RX(m_dataRate);
+}
+
+word RFMxx::GetListenIdleMicros() {
+  return GetListenIdle() * 64;
+}
+
+word RFMxx::GetListenRxMicros() {
+  return GetListenRx() * 64;
+}
+
+byte RFMxx::GetListenRssi() {
+  return m_listenRssi;
+}
+
+// Estimated average current in uA without signal: 16 mA in RX, 1.2 uA in idle
+word RFMxx::GetListenCurrent() {
+  unsigned long rx = GetListenRx();
+  unsigned long idle = GetListenIdle();
+  return (16000UL * rx + idle * 6 / 5) / (rx + idle);
+}
+
+unsigned long RFMxx::GetListenFrames() {
+  return m_listenFrames;
+}
+
+unsigned long RFMxx::GetListenTimeouts() {
+  return m_listenTimeouts;
+}
+
+unsigned long RFMxx::GetMergedRepeats() {
+  return m_repeatsMerged;
+}
+
+unsigned long RFMxx::GetEvictedRepeats() {
+  return m_repeatsEvicted;
+}
+
+void RFMxx::WriteListenTiming() {
+#ifdef _RFM69_h
+  byte listen[3] = { RF_LISTEN1_RESOL_64 | RF_LISTEN1_CRITERIA_RSSI | RF_LISTEN1_END_01, GetListenIdle(), GetListenRx() };
+  WriteBurst(REG_LISTEN1, listen, sizeof(listen));
+  WriteReg(REG_RSSITHRESH, m_listenRssi * 2);
+  // A wake up by noise ends after the time of the payload, sync word and a margin (16 bit units)
+  WriteReg(REG_RXTIMEOUT2, (m_payloadLength + 2) / 2 + 4);
+#endif
+}
+
+// The end of a listen cycle has to be acknowledged with ListenAbort before it starts again
+void RFMxx::StartListen() {
+#ifdef _RFM69_h
+  SetOpMode(RF_OPMODE_STANDBY);
+  WriteReg(REG_OPMODE, m_shadow[REG_OPMODE] | RF_OPMODE_LISTEN_ON);
+#endif
+}
+
+// One burst read of the configuration registers, WriteReg keeps them coherent
+void RFMxx::LoadShadow() {
+  // The FIFO at address 0 is not incremented in a burst, it is left out
+  ReadBurst(1, m_shadow + 1, SHADOW_SIZE - 1);
+}
+
+// Registers the chip changes itself: status, measurements and trigger bits
+#ifdef _RFM69_h
+static const byte volatileRegisters[] = { REG_OSC1, REG_LOWBAT, REG_LNA, REG_AFCFEI, REG_AFCMSB, REG_AFCLSB, REG_FEIMSB,
+  REG_FEILSB, REG_RSSICONFIG, REG_RSSIVALUE, REG_IRQFLAGS1, REG_IRQFLAGS2, REG_TEMP1, REG_TEMP2 };
+#else
+static const byte volatileRegisters[] = { REG_LNA, REG_RSSIVALUE, REG_AFCFEI, REG_AFCMSB, REG_AFCLSB, REG_FEIMSB,
+  REG_FEILSB, REG_IMAGECAL, REG_TEMP, REG_LOWBAT, REG_IRQFLAGS1, REG_IRQFLAGS2 };
+#endif
+
+// Compare the shadow with the chip and report the registers that differ
+byte RFMxx::VerifyShadow() {
+  byte mismatches = 0;
+  if (!(IsRF69 || IsSX127x)) {
+    return 0;
+  }
+  for (byte addr = 1; addr < SHADOW_SIZE; addr++) {
+    byte i = 0;
+    while (i < sizeof(volatileRegisters) && volatileRegisters[i] != addr) {
+      i++;
+    }
+    if (i < sizeof(volatileRegisters)) {
+      continue;
+    }
+    byte value = ReadReg(addr);
+    if (value != m_shadow[addr]) {
+      mismatches++;
+      Serial.print(F("[Shadow 0x"));
+      Serial.print(addr, HEX);
+      Serial.print(F(" Chip:"));
+      Serial.print(value, HEX);
+      Serial.print(F(" Shadow:"));
+      Serial.print(m_shadow[addr], HEX);
+      Serial.println(F("]"));
+    }
+  }
+  return mismatches;
+}
+
+// Average SPI transactions to take a frame and resume the receiver
+word RFMxx::GetSpiTransactionsPerFrame() {
+  return m_frameTransactionCount ? m_frameTransactionSum / m_frameTransactionCount : 0;
 }
 
 void RFMxx::EnableTransmitter(bool enable){
   if (enable) {
     if (IsRF69 || IsSX127x) {
-      WriteReg(REG_OPMODE, (ReadReg(REG_OPMODE) & RF_OPMODE_MASK) | RF_OPMODE_TRANSMITTER);
+      SetOpMode(RF_OPMODE_TRANSMITTER);
     }
     else {
+      // The ring would take the TX ready status and read the FIFO in the middle of the frame
+      EnableInterruptRing(false);
       spi16(0x8238);
     }
   }
   else {
     if (IsRF69 || IsSX127x) {
-      WriteReg(REG_OPMODE, (ReadReg(REG_OPMODE) & RF_OPMODE_MASK) | RF_OPMODE_STANDBY);
+      SetOpMode(RF_OPMODE_STANDBY);
     }
     else {
       spi16(0x8208);
@@ -248,16 +1044,80 @@ bool RFMxx::ClearFifo() {
 
 void RFMxx::PowerDown(){
   if (IsRF69 || IsSX127x) {
-    WriteReg(REG_OPMODE, (ReadReg(REG_OPMODE) & RF_OPMODE_MASK) | RF_OPMODE_SLEEP);
+    SetOpMode(RF_OPMODE_SLEEP);
   }
   else {
+    EnableInterruptRing(false);
     spi16(0x8201);
   }
 }
 
+// Register tables of the chips: runs of <first register>,<count>,<values>, a 0 ends the table.
+// Every run is one SPI burst, the data rate is the one of the first profile.
+#ifdef __SX1276_REGS_FSK_H__
+static const byte sx127xInit[] PROGMEM = {
+  REG_OPMODE, 5, RF_OPMODE_LONGRANGEMODE_OFF | RF_OPMODE_MODULATIONTYPE_FSK | RF_OPMODE_MODULATIONSHAPING_00 | RF_OPMODE_STANDBY,
+    BITRATE_REG(17241) >> 8, BITRATE_REG(17241) & 0xFF, RF_FDEVMSB_90000_HZ, RF_FDEVLSB_90000_HZ,
+  REG_OCP, 1, RF_OCP_OFF,
+  REG_RSSITHRESH, 1, 220,
+  REG_RXBW, 1, RF_RXBW_MANT_16 | RF_RXBW_EXP_2,
+  REG_SYNCCONFIG, 3, RF_SYNCCONFIG_AUTORESTARTRXMODE_WAITPLL_ON | RF_SYNCCONFIG_SYNC_ON | RF_SYNCCONFIG_SYNCSIZE_2, 0x2D, 0xD4,
+  REG_PACKETCONFIG1, 3, RF_PACKETCONFIG1_CRCAUTOCLEAR_OFF, RF_PACKETCONFIG2_DATAMODE_PACKET, PAYLOADSIZE,
+  REG_FIFOTHRESH, 1, RF_FIFOTHRESH_TXSTARTCONDITION_FIFONOTEMPTY | RF_FIFOTHRESH_FIFOTHRESHOLD_THRESHOLD,
+  REG_IRQFLAGS2, 1, RF_IRQFLAGS2_FIFOOVERRUN,
+  0
+};
+#endif
+
+#ifdef _RFM69_h
+static const byte rfm69Init[] PROGMEM = {
+  REG_OPMODE, 6, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF | RF_OPMODE_STANDBY,
+    RF_DATAMODUL_DATAMODE_PACKET | RF_DATAMODUL_MODULATIONTYPE_FSK | RF_DATAMODUL_MODULATIONSHAPING_00,
+    BITRATE_REG(17241) >> 8, BITRATE_REG(17241) & 0xFF, RF_FDEVMSB_90000, RF_FDEVLSB_90000,
+  REG_PALEVEL, 3, RF_PALEVEL_PA0_ON | RF_PALEVEL_PA1_OFF | RF_PALEVEL_PA2_OFF | RF_PALEVEL_OUTPUTPOWER_11111, RF_PARAMP_40, RF_OCP_OFF,
+  REG_RXBW, 1, RF_RXBW_DCCFREQ_010 | RF_RXBW_MANT_16 | RF_RXBW_EXP_2,
+  REG_IRQFLAGS2, 2, RF_IRQFLAGS2_FIFOOVERRUN, 220,
+  REG_SYNCCONFIG, 3, RF_SYNC_ON | RF_SYNC_FIFOFILL_AUTO | RF_SYNC_SIZE_2 | RF_SYNC_TOL_0, 0x2D, 0xD4,
+  REG_PACKETCONFIG1, 2, RF_PACKET1_CRCAUTOCLEAR_OFF, PAYLOADSIZE,
+  REG_FIFOTHRESH, 2, RF_FIFOTHRESH_TXSTART_FIFONOTEMPTY | RF_FIFOTHRESH_VALUE, RF_PACKET2_RXRESTARTDELAY_2BITS | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF,
+  REG_TESTDAGC, 1, RF_DAGC_IMPROVED_LOWBETA0,
+  0
+};
+#endif
+
+// The RFM12B takes 16 bit commands, one transfer each
+static const word rfm12Init[] PROGMEM = {
+  0x8208,                       // RX/TX off
+  0x80E8,                       // 80e8 CONFIGURATION EL,EF,868 band,12.5pF  (iT+ 915  80f8)
+  0xC26a,                       // DATA FILTER
+  0xCA12,                       // FIFO AND RESET  8,SYNC,!ff,DR
+  0xCEd4,                       // SYNCHRON PATTERN  0x2dd4
+  0xC481,                       // AFC during VDI HIGH
+  0x94a0,                       // RECEIVER CONTROL VDI Medium 134khz LNA max DRRSI 103 dbm
+  0xCC77,                       //
+  0x9850,                       // Deviation 90 kHz
+  0xE000,                       //
+  0xC800,                       //
+  0xC040                        // 1.66MHz,2.2V
+};
+
+void RFMxx::WriteTable(const byte *table) {
+  byte run[8];
+  for (;;) {
+    byte addr = pgm_read_byte(table++);
+    if (addr == 0) {
+      break;
+    }
+    byte count = pgm_read_byte(table++);
+    memcpy_P(run, table, count);
+    table += count;
+    WriteBurst(addr, run, count);
+  }
+}
+
 void RFMxx::InitialzeLaCrosse() {
   if (m_debug) {
-    Serial.print("Radio is: ");
+    Serial.print(F("Radio is: "));
     Serial.println(GetRadioName());
   }
 
@@ -266,68 +1126,27 @@ void RFMxx::InitialzeLaCrosse() {
 #ifdef USE_SX127x
   if (IsSX127x) {
 #ifdef __SX1276_REGS_FSK_H__
-    /* 0x01 */ WriteReg(REG_OPMODE, RF_OPMODE_LONGRANGEMODE_OFF | RF_OPMODE_MODULATIONTYPE_FSK | RF_OPMODE_MODULATIONSHAPING_00 | RF_OPMODE_STANDBY);
-    ///* 0x02 */ WriteReg(REG_DATAMODUL, RF_DATAMODUL_DATAMODE_PACKET | RF_DATAMODUL_MODULATIONTYPE_FSK | RF_DATAMODUL_MODULATIONSHAPING_00);
-    /* 0x04 */ WriteReg(REG_FDEVMSB, RF_FDEVMSB_90000_HZ);
-    /* 0x05 */ WriteReg(REG_FDEVLSB, RF_FDEVLSB_90000_HZ);
-    ///* 0x09 */ WriteReg(REG_PACONFIG, RF_PACONFIG_PASELECT_RFO | RF_PACONFIG_OUTPUTPOWER_MASK);
-    /* 0x13 */ WriteReg(REG_OCP, RF_OCP_OFF);
-    /* 0x12 */ WriteReg(REG_RXBW, RF_RXBW_MANT_16 | RF_RXBW_EXP_2);
-    /* 0x3F */ WriteReg(REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN);
-    /* 0x29 */ WriteReg(REG_RSSITHRESH, 220);
-    /* 0x27 */ WriteReg(REG_SYNCCONFIG, RF_SYNCCONFIG_AUTORESTARTRXMODE_WAITPLL_ON | RF_SYNCCONFIG_SYNC_ON | RF_SYNCCONFIG_SYNCSIZE_2);
-    /* 0x28 */ WriteReg(REG_SYNCVALUE1, 0x2D);
-    /* 0x29 */ WriteReg(REG_SYNCVALUE2, 0xD4);
-    /* 0x30 */ WriteReg(REG_PACKETCONFIG1, RF_PACKETCONFIG1_CRCAUTOCLEAR_OFF);
-    /* 0x31 */ WriteReg(REG_PACKETCONFIG2, RF_PACKETCONFIG2_DATAMODE_PACKET);
-    /* 0x38 */ WriteReg(REG_PAYLOADLENGTH, PAYLOADSIZE);
-    /* 0x35 */ WriteReg(REG_FIFOTHRESH, RF_FIFOTHRESH_TXSTARTCONDITION_FIFONOTEMPTY | RF_FIFOTHRESH_FIFOTHRESHOLD_THRESHOLD);
-   // /* 0x3D */ WriteReg(REG_PACKETCONFIG2, RF_PACKET2_RXRESTARTDELAY_2BITS | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF);
-    ///* 0x6F */ WriteReg(REG_TESTDAGC, RF_DAGC_IMPROVED_LOWBETA0);
+    WriteTable(sx127xInit);
 #else
-	    Serial.print("Recompile for SX127x");
+	    Serial.print(F("Recompile for SX127x"));
 #endif
   }
   else
 #endif
   if (IsRF69) {
 #ifdef _RFM69_h
-    /* 0x01 */ WriteReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF | RF_OPMODE_STANDBY);
-    /* 0x02 */ WriteReg(REG_DATAMODUL, RF_DATAMODUL_DATAMODE_PACKET | RF_DATAMODUL_MODULATIONTYPE_FSK | RF_DATAMODUL_MODULATIONSHAPING_00);
-    /* 0x05 */ WriteReg(REG_FDEVMSB, RF_FDEVMSB_90000);
-    /* 0x06 */ WriteReg(REG_FDEVLSB, RF_FDEVLSB_90000);
-    /* 0x11 */ WriteReg(REG_PALEVEL, RF_PALEVEL_PA0_ON | RF_PALEVEL_PA1_OFF | RF_PALEVEL_PA2_OFF | RF_PALEVEL_OUTPUTPOWER_11111);
-    /* 0x13 */ WriteReg(REG_OCP, RF_OCP_OFF);
-    /* 0x19 */ WriteReg(REG_RXBW, RF_RXBW_DCCFREQ_010 | RF_RXBW_MANT_16 | RF_RXBW_EXP_2);
-    /* 0x28 */ WriteReg(REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN);
-    /* 0x29 */ WriteReg(REG_RSSITHRESH, 220);
-    /* 0x2E */ WriteReg(REG_SYNCCONFIG, RF_SYNC_ON | RF_SYNC_FIFOFILL_AUTO | RF_SYNC_SIZE_2 | RF_SYNC_TOL_0);
-    /* 0x2F */ WriteReg(REG_SYNCVALUE1, 0x2D);
-    /* 0x30 */ WriteReg(REG_SYNCVALUE2, 0xD4);
-    /* 0x37 */ WriteReg(REG_PACKETCONFIG1, RF_PACKET1_CRCAUTOCLEAR_OFF);
-    /* 0x38 */ WriteReg(REG_PAYLOADLENGTH, PAYLOADSIZE);
-    /* 0x3C */ WriteReg(REG_FIFOTHRESH, RF_FIFOTHRESH_TXSTART_FIFONOTEMPTY | RF_FIFOTHRESH_VALUE);
-    /* 0x3D */ WriteReg(REG_PACKETCONFIG2, RF_PACKET2_RXRESTARTDELAY_2BITS | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF);
-    /* 0x6F */ WriteReg(REG_TESTDAGC, RF_DAGC_IMPROVED_LOWBETA0);
+    WriteTable(rfm69Init);
 #else
-	    Serial.print("Recompile for RFM69");
+	    Serial.print(F("Recompile for RFM69"));
 #endif
   }
   else {
-    spi16(0x8208);              // RX/TX off
-    spi16(0x80E8);              // 80e8 CONFIGURATION EL,EF,868 band,12.5pF  (iT+ 915  80f8)
-    spi16(0xC26a);              // DATA FILTER
-    spi16(0xCA12);              // FIFO AND RESET  8,SYNC,!ff,DR
-    spi16(0xCEd4);              // SYNCHRON PATTERN  0x2dd4
-    spi16(0xC481);              // AFC during VDI HIGH
-    spi16(0x94a0);              // RECEIVER CONTROL VDI Medium 134khz LNA max DRRSI 103 dbm
-    spi16(0xCC77);              //
-    spi16(0x9850);              // Deviation 90 kHz
-    spi16(0xE000);              //
-    spi16(0xC800);              //
-    spi16(0xC040);              // 1.66MHz,2.2V
+    for (byte i = 0; i < sizeof(rfm12Init) / sizeof(rfm12Init[0]); i++) {
+      spi16(pgm_read_word(&rfm12Init[i]));
+    }
   }
 
+  m_bandwidth = (IsRF69 || IsSX127x) ? 125 : 134;
   SetFrequency(m_frequency);
   SetDataRate(m_dataRate);
 
@@ -337,7 +1156,8 @@ void RFMxx::InitialzeLaCrosse() {
 byte RFMxx::GetTemperature() {
   byte result = 0;
   if (IsRF69 || IsSX127x) {
-    byte receiverWasOn = ReadReg(REG_OPMODE) & RF_OPMODE_RECEIVER;
+    // The listen mode receives in standby between its RX phases, EnableReceiver starts it again
+    bool receiverWasOn = m_listen || (m_shadow[REG_OPMODE] & ~RF_OPMODE_MASK) == RF_OPMODE_RECEIVER;
 
     EnableReceiver(false);
 
@@ -356,33 +1176,56 @@ byte RFMxx::GetTemperature() {
   return result;
 }
 
-#define clrb(pin) (*portOutputRegister(digitalPinToPort(pin)) &= ~digitalPinToBitMask(pin))
-#define setb(pin) (*portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin))
 #ifndef USE_SPI8_H
+#if defined(RFM_SPI_FIXED_PINS) && defined(__AVR_ATmega328P__)
+// Pin numbers known at compile time make every access a single sbi, cbi or sbic
+template<byte pin> struct PortBPin {
+  static_assert(pin >= 8 && pin <= 13, "pins 8..13 are PB0..PB5");
+  static inline void High() { PORTB |= _BV(pin - 8); }
+  static inline void Low() { PORTB &= ~_BV(pin - 8); }
+  static inline bool Read() { return PINB & _BV(pin - 8); }
+};
+#define MOSI_HIGH() PortBPin<RFM_SPI_MOSI>::High()
+#define MOSI_LOW() PortBPin<RFM_SPI_MOSI>::Low()
+#define SCK_HIGH() PortBPin<RFM_SPI_SCK>::High()
+#define SCK_LOW() PortBPin<RFM_SPI_SCK>::Low()
+#define SS_HIGH() PortBPin<RFM_SPI_SS>::High()
+#define SS_LOW() PortBPin<RFM_SPI_SS>::Low()
+#define MISO_READ() PortBPin<RFM_SPI_MISO>::Read()
+#else
+#define MOSI_HIGH() (*m_mosiOut |= m_mosiBit)
+#define MOSI_LOW() (*m_mosiOut &= ~m_mosiBit)
+#define SCK_HIGH() (*m_sckOut |= m_sckBit)
+#define SCK_LOW() (*m_sckOut &= ~m_sckBit)
+#define SS_HIGH() (*m_ssOut |= m_ssBit)
+#define SS_LOW() (*m_ssOut &= ~m_ssBit)
+#define MISO_READ() (*m_misoIn & m_misoBit)
+#endif
+
+// The ring interrupt shares the pins, a transfer must not be split by it. The flag is
+// restored, so a transfer inside the interrupt does not enable it again.
+#define SPI_LOCK() byte sreg = SREG; noInterrupts()
+#define SPI_UNLOCK() SREG = sreg
+
+// MISO is sampled after the rising edge
+#define SPI8_BIT(mask) \
+  SCK_LOW(); \
+  if (value & (mask)) { MOSI_HIGH(); } else { MOSI_LOW(); } \
+  SCK_HIGH(); \
+  if (MISO_READ()) { result |= (mask); }
+
 byte RFMxx::spi8(byte value) {
-  volatile byte *misoPort = portInputRegister(digitalPinToPort(m_miso));
-  byte misoBit = digitalPinToBitMask(m_miso);
-  for (byte i = 8; i; i--) {
-    clrb(m_sck);
-    if (value & 0x80) {
-      setb(m_mosi);
-    }
-    else {
-      clrb(m_mosi);
-    }
-    value <<= 1;
-    setb(m_sck);
-    if (*misoPort & misoBit) {
-      value |= 1;
-    }
-  }
-  clrb(m_sck);
+  byte result = 0;
+  SPI8_BIT(0x80) SPI8_BIT(0x40) SPI8_BIT(0x20) SPI8_BIT(0x10)
+  SPI8_BIT(0x08) SPI8_BIT(0x04) SPI8_BIT(0x02) SPI8_BIT(0x01)
+  SCK_LOW();
 
-  return value;
+  return result;
 }
 #else
 byte RFMxx::spi8(byte value) {
   byte res;
+  m_spiTransactions++;
   SPI.beginTransaction(SPISettings(SPI_CLOCK_DIV4, MSBFIRST, SPI_MODE0));
   digitalWrite(m_ss, LOW);
   res = SPI.transfer(value);
@@ -394,33 +1237,32 @@ byte RFMxx::spi8(byte value) {
 #endif
 
 #ifndef USE_SPI16_H
-unsigned short RFMxx::spi16(unsigned short value) {
-  volatile byte *misoPort = portInputRegister(digitalPinToPort(m_miso));
-  byte misoBit = digitalPinToBitMask(m_miso);
+// The RFM12B drives SDO before the rising edge, MISO is sampled first
+#define SPI16_BIT(mask) \
+  if (value & (mask)) { MOSI_HIGH(); } else { MOSI_LOW(); } \
+  if (MISO_READ()) { result |= (mask); } \
+  SCK_HIGH(); \
+  asm("nop"); \
+  asm("nop"); \
+  SCK_LOW();
 
-  clrb(m_ss);
-  for (byte i = 0; i < 16; i++) {
-    if (value & 32768) {
-      setb(m_mosi);
-    }
-    else {
-      clrb(m_mosi);
-    }
-    value <<= 1;
-    if (*misoPort & misoBit) {
-      value |= 1;
-    }
-    setb(m_sck);
-    asm("nop");
-    asm("nop");
-    clrb(m_sck);
-  }
-  setb(m_ss);
-  return value;
+unsigned short RFMxx::spi16(unsigned short value) {
+  unsigned short result = 0;
+  m_spiTransactions++;
+  SPI_LOCK();
+  SS_LOW();
+  SPI16_BIT(0x8000) SPI16_BIT(0x4000) SPI16_BIT(0x2000) SPI16_BIT(0x1000)
+  SPI16_BIT(0x0800) SPI16_BIT(0x0400) SPI16_BIT(0x0200) SPI16_BIT(0x0100)
+  SPI16_BIT(0x0080) SPI16_BIT(0x0040) SPI16_BIT(0x0020) SPI16_BIT(0x0010)
+  SPI16_BIT(0x0008) SPI16_BIT(0x0004) SPI16_BIT(0x0002) SPI16_BIT(0x0001)
+  SS_HIGH();
+  SPI_UNLOCK();
+  return result;
 }
 #else
 unsigned short RFMxx::spi16(unsigned short value) {
   unsigned short res;
+  m_spiTransactions++;
   SPI.beginTransaction(SPISettings(SPI_CLOCK_DIV4, MSBFIRST, SPI_MODE0));
   digitalWrite(m_ss, LOW);
   res = SPI.transfer16(value);
@@ -431,11 +1273,14 @@ unsigned short RFMxx::spi16(unsigned short value) {
 #endif
 
 byte RFMxx::ReadReg(byte addr) {
+  m_spiTransactions++;
 #ifndef USE_SPI8_H
-  digitalWrite(m_ss, LOW);
+  SPI_LOCK();
+  SS_LOW();
   spi8(addr & 0x7F);
   byte regval = spi8(0);
-  digitalWrite(m_ss, HIGH);
+  SS_HIGH();
+  SPI_UNLOCK();
   return regval;
 #else
   SPI.beginTransaction(SPISettings(SPI_CLOCK_DIV4, MSBFIRST, SPI_MODE0));
@@ -449,12 +1294,26 @@ byte RFMxx::ReadReg(byte addr) {
 }
 
 void RFMxx::WriteReg(byte addr, byte value) {
+  m_spiTransactions++;
+  if (addr < SHADOW_SIZE) {
+    // Trigger bits read back as 0, a read-modify-write must not repeat them
+#ifdef _RFM69_h
+    m_shadow[addr] = addr == REG_PACKETCONFIG2 ? value & ~RF_PACKET2_RXRESTART : value;
+    if (addr == REG_OPMODE) {
+      m_shadow[addr] &= ~RF_OPMODE_LISTENABORT;
+    }
+#else
+    m_shadow[addr] = addr == REG_RXCONFIG ? value & ~(RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK | RF_RXCONFIG_RESTARTRXWITHPLLLOCK) : value;
+#endif
+  }
 #ifndef USE_SPI8_H
-  digitalWrite(m_ss, LOW);
+  SPI_LOCK();
+  SS_LOW();
   spi8(addr | 0x80);
   spi8(value);
 
-  digitalWrite(m_ss, HIGH);
+  SS_HIGH();
+  SPI_UNLOCK();
 #else
   SPI.beginTransaction(SPISettings(SPI_CLOCK_DIV4, MSBFIRST, SPI_MODE0));
   digitalWrite(m_ss, LOW);
@@ -465,6 +1324,74 @@ void RFMxx::WriteReg(byte addr, byte value) {
 #endif
 }
 
+void RFMxx::Select() {
+  m_spiTransactions++;
+#ifdef USE_SPI8_H
+  SPI.beginTransaction(SPISettings(SPI_CLOCK_DIV4, MSBFIRST, SPI_MODE0));
+  digitalWrite(m_ss, LOW);
+#else
+  // Held until Deselect, a burst is a single transfer
+  m_spiSreg = SREG;
+  noInterrupts();
+  SS_LOW();
+#endif
+}
+
+void RFMxx::Deselect() {
+#ifdef USE_SPI8_H
+  digitalWrite(m_ss, HIGH);
+  SPI.endTransaction();
+#else
+  SS_HIGH();
+  SREG = m_spiSreg;
+#endif
+}
+
+byte RFMxx::Transfer(byte value) {
+#ifndef USE_SPI8_H
+  return spi8(value);
+#else
+  return SPI.transfer(value);
+#endif
+}
+
+// Effective SPI clock in kHz including the transaction overhead: 100 transfers of 16 bits
+unsigned long RFMxx::MeasureSpiClock() {
+  unsigned long start = micros();
+  for (byte i = 0; i < 100; i++) {
+    if (IsRF69 || IsSX127x) {
+      ReadReg(REG_OPMODE);
+    }
+    else {
+      spi16(0);
+    }
+  }
+  unsigned long elapsed = micros() - start;
+  return elapsed ? 1600000UL / elapsed : 0;
+}
+
+void RFMxx::WriteBurst(byte addr, const byte *data, byte length) {
+  Select();
+  Transfer(addr | 0x80);
+  for (byte i = 0; i < length; i++) {
+    Transfer(data[i]);
+  }
+  Deselect();
+  // The FIFO address does not increment
+  for (byte i = 0; addr != REG_FIFO && i < length && addr + i < SHADOW_SIZE; i++) {
+    m_shadow[addr + i] = data[i];
+  }
+}
+
+void RFMxx::ReadBurst(byte addr, byte *data, byte length) {
+  Select();
+  Transfer(addr & 0x7F);
+  for (byte i = 0; i < length; i++) {
+    data[i] = Transfer(0);
+  }
+  Deselect();
+}
+
 RFMxx::RadioType RFMxx::GetRadioType() {
   return m_radioType;
 }
@@ -489,23 +1416,28 @@ void RFMxx::init() {
 	  pinMode(m_sck, OUTPUT);
 	  pinMode(m_ss, OUTPUT);
 	  pinMode(m_irq, INPUT);
-	  delay(10);
+	  m_mosiOut = portOutputRegister(digitalPinToPort(m_mosi));
+	  m_mosiBit = digitalPinToBitMask(m_mosi);
+	  m_sckOut = portOutputRegister(digitalPinToPort(m_sck));
+	  m_sckBit = digitalPinToBitMask(m_sck);
+	  m_ssOut = portOutputRegister(digitalPinToPort(m_ss));
+	  m_ssBit = digitalPinToBitMask(m_ss);
+	  m_misoIn = portInputRegister(digitalPinToPort(m_miso));
+	  m_misoBit = digitalPinToBitMask(m_miso);
 
 	  digitalWrite(m_ss, HIGH);
 #else
 	  pinMode(m_irqPin, INPUT);
 	  pinMode(m_ss, OUTPUT);
-	  delay(10);
 	  digitalWrite(m_ss, HIGH);
 #ifdef USE_SX127x
 	  if (m_reset != -1) {
 		pinMode(m_reset, OUTPUT);
 
-		// perform reset
+		// perform reset, the chip needs 100 us
 		digitalWrite(m_reset, LOW);
-		delay(10);
+		delayMicroseconds(100);
 		digitalWrite(m_reset, HIGH);
-		delay(10);
 	  }
 #endif
 #if 0
@@ -515,24 +1447,36 @@ void RFMxx::init() {
 #endif
 	  SPI.begin();
 #endif
+  WaitReady();
 #ifdef USE_SX127x
   // check version
   uint8_t version = ReadReg(REG_VERSION);
-  if (version = 0x12) {
+  if (version == 0x12) {
 	m_radioType = RFMxx::SX127x;
 	    WriteReg(REG_PAYLOADLENGTH, 0x40);
+    LoadShadow();
     return;
   }
 #endif
 
+	  // One read tells the RFM69 by its silicon version, the RFM12B has no registers to read
 	  m_radioType = RFMxx::RFM12B;
-	  WriteReg(REG_PAYLOADLENGTH, 0xA);
-	  if (ReadReg(REG_PAYLOADLENGTH) == 0xA) {
-	    WriteReg(REG_PAYLOADLENGTH, 0x40);
-	    if (ReadReg(REG_PAYLOADLENGTH) == 0x40) {
-	      m_radioType = RFMxx::RFM69CW;
-	    }
+	  if ((ReadReg(REG_VERSION) & 0xF0) == 0x20) {
+	    m_radioType = RFMxx::RFM69CW;
+	    LoadShadow();
 	  }
+}
+
+// Poll ModeReady instead of waiting out the 10 ms of the power on reset. The RFM12B
+// never reports it and gets the full 10 ms. delay() would not work here, without
+// SPI.h init() runs in the constructor before the timer is started.
+void RFMxx::WaitReady() {
+  for (byte i = 0; i < 100; i++) {
+    if (ReadReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) {
+      return;
+    }
+    delayMicroseconds(100);
+  }
 }
 
 #ifndef USE_SPI_H
@@ -551,10 +1495,44 @@ RFMxx::RFMxx(byte ss, byte irqPin, byte reset) {
   m_debug = false;
   m_dataRate = 17241;
   m_frequency = 868300;
+  m_bandwidth = 125;
   m_payloadPointer = 0;
   m_lastReceiveTime = 0;
   m_payloadReady = false;
   m_payload_crc = 0;
+  m_receiveMode = RX_FIXED_LENGTH;
+  m_payloadLength = PAYLOADSIZE;
+  m_signalSampled = false;
+  m_rssi = 0;
+  m_fei = 0;
+  m_payloadRssi = 0;
+  m_payloadFei = 0;
+  m_syncMicros = 0;
+  m_syncCount = 0;
+  ResetLatency();
+  m_blind = false;
+  m_blindSince = 0;
+  m_blindMicros = 0;
+  m_blindMillis = 0;
+  m_blindCount = 0;
+  m_lastTicks = 0;
+  m_profile = 0;
+  m_profileSwitchMicros = 0;
+  m_listen = false;
+  m_listenIdle = 0;
+  m_listenRx = 0;
+  m_listenRssi = 100;
+  m_listenFrames = 0;
+  m_listenTimeouts = 0;
+  m_spiTransactions = 0;
+  m_spiPolls = 0;
+  m_frameTransactionStart = 0;
+  m_frameTransactionSum = 0;
+  m_frameTransactionCount = 0;
+  memset(m_shadow, 0, SHADOW_SIZE);
+  memset(m_repeats, 0, sizeof(m_repeats));
+  m_repeatsMerged = 0;
+  m_repeatsEvicted = 0;
 #ifndef USE_SPI_H
 	init();
 #endif
@@ -581,27 +1559,22 @@ void RFMxx::SendArray(byte *data, byte length) {
 if (IsRF69 || IsSX127x) {
 	if (IsRF69) {
 	#ifdef _RFM69_h
-		WriteReg(REG_PACKETCONFIG2, (ReadReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
+		WriteReg(REG_PACKETCONFIG2, m_shadow[REG_PACKETCONFIG2] | RF_PACKET2_RXRESTART); // avoid RX deadlocks
 	#else
-		Serial.print("Recompile for RFM69");
+		Serial.print(F("Recompile for RFM69"));
 	#endif
 	}
 	else {
-		WriteReg(REG_RXCONFIG, (ReadReg(REG_PACKETCONFIG2)) | RF_RXCONFIG_RESTARTRXWITHPLLLOCK);
+	#ifdef USE_SX127x
+		WriteReg(REG_RXCONFIG, m_shadow[REG_RXCONFIG] | RF_RXCONFIG_RESTARTRXWITHPLLLOCK);
+	#endif
 	}
     EnableReceiver(false);
     ClearFifo();
 
-    noInterrupts();
-    digitalWrite(m_ss, LOW);
-
-    spi8(REG_FIFO | 0x80);
-    for (byte i = 0; i < length; i++) {
-      spi8(data[i]);
-    }
-
-    digitalWrite(m_ss, HIGH);
-    interrupts();
+    // With SPI.h spi8 selects the chip for every byte, the FIFO needs a single burst.
+    // The bit-banged burst keeps interrupts off in Select, SPI.h needs them for its transaction.
+    WriteBurst(REG_FIFO, data, length);
 
     EnableTransmitter(true);
 
@@ -633,10 +1606,10 @@ if (IsRF69 || IsSX127x) {
   }
 
   if (m_debug) {
-    Serial.print("Sending data: ");
+    Serial.print(F("Sending data: "));
     for (int p = 0; p < length; p++) {
       Serial.print(data[p], DEC);
-      Serial.print(" ");
+      Serial.print(F(" "));
     }
     Serial.println();
   }
@@ -3,10 +3,16 @@
 
 #include "Arduino.h"
 #define USE_SPI_H
-#define USE_TIME_H
-#ifdef ESP32
+#ifdef ESP32
 #define USE_SX127x
 #endif
+
+// Without SPI.h only: bit-banged SPI on pins fixed at compile time (ATmega328, pins 8..13 on port B)
+//#define RFM_SPI_FIXED_PINS
+#define RFM_SPI_MOSI 11
+#define RFM_SPI_MISO 12
+#define RFM_SPI_SCK 13
+#define RFM_SPI_SS 10
 
 #define PAYLOADSIZE 64
 #define IsRF69 (m_radioType == RFM69CW)
@@ -21,6 +27,14 @@ public:
     SX127x = 3
   };
 
+  enum ReceiveMode {
+    RX_FIXED_LENGTH = 0,
+    RX_LENGTH_AWARE = 1,   // payload length of the protocols at the data rate, RX restarts right away
+    RX_STREAMING = 2,      // bytes are taken while the frame is on air, complete when a protocol recognises it
+    RX_FAST_RESTART = 4,   // RX restart after a payload instead of standby, RX and clearing the FIFO
+    RX_IRQ_RING = 8        // RFM12B only: nIRQ interrupt reads the FIFO into a ring buffer
+  };
+
 #ifndef USE_SPI_H
   RFMxx(byte mosi, byte miso, byte sck, byte ss, byte irq);
 #else
@@ -31,11 +45,22 @@ public:
   byte GetPayload(byte *data);
   void InitialzeLaCrosse();
   void SendArray(byte *data, byte length);
+  static const byte PROFILE_COUNT = 3;
   void SetDataRate(unsigned long dataRate);
+  void SetProfile(byte index);
+  byte GetProfile();
+  unsigned long GetProfileSwitchMicros();
   unsigned long GetDataRate();
   void SetFrequency(unsigned long kHz);
   unsigned long GetFrequency();
+  void SetBandwidth(word kHz);
+  word GetBandwidth();
+  word RoundBandwidth(word kHz, byte *bits = NULL);
   void EnableReceiver(bool enable, bool fClearFifo = true);
+  void ResumeReceiver();
+  void RestartReceiver(bool pllLock = false);
+  void SetReceiveMode(byte mode);
+  byte GetReceiveMode();
   void EnableTransmitter(bool enable);
   static byte CalculateCRC(byte data[], int len);
   void PowerDown();
@@ -45,28 +70,145 @@ public:
   String GetRadioName();
   void Receive();
   bool ReceiveGetPayloadWhenReady(byte *data, byte &length, byte &packetCount);
+  int GetRssi();
+  long GetFei();
+  unsigned long GetLatency();
+  unsigned long GetLatencyMax();
+  void ResetLatency();
+  unsigned long GetBlindMillis();
+  unsigned long GetBlindCount();
+  byte GetRingOverflows();
+  bool EnableListen(bool enable);
+  void SetListenTiming(byte idle, byte rx, byte rssi);
+  bool IsListening();
+  bool IsReceiving();
+  word GetListenIdleMicros();
+  word GetListenRxMicros();
+  byte GetListenRssi();
+  word GetListenCurrent();
+  unsigned long GetListenFrames();
+  unsigned long GetListenTimeouts();
+  unsigned long GetMergedRepeats();
+  unsigned long GetEvictedRepeats();
+  int MeasureRssi();
+  unsigned long GetSyncCount();
+  unsigned long MeasureSpiClock();
+  byte VerifyShadow();
+  word GetSpiTransactionsPerFrame();
 private:
+  static const byte REPEAT_CANDIDATES = 3;
+  static const byte REPEAT_FRAME_SIZE = 16;
+  struct RepeatCandidate {
+    byte data[REPEAT_FRAME_SIZE];
+    byte length;
+    byte count;          // copies received, 0 = free
+    int rssi;
+    long fei;
+    unsigned long lastSeen;
+  };
+
   RadioType m_radioType;
 #ifndef USE_SPI_H
   byte m_mosi, m_miso, m_sck, m_ss, m_irq;
+  // Resolved once in init, the bit-banged transfers only touch the registers
+  volatile byte *m_mosiOut, *m_sckOut, *m_ssOut, *m_misoIn;
+  byte m_mosiBit, m_sckBit, m_ssBit, m_misoBit;
+  byte m_spiSreg;      // interrupt flag from Select, restored by Deselect
 #else
   byte m_ss, m_irqPin, m_reset;
 #endif
   bool m_debug;
   unsigned long m_dataRate;
   unsigned long m_frequency;
+  word m_bandwidth;
   byte m_payloadPointer;
   unsigned long m_lastReceiveTime;
   bool m_payloadReady;
   byte m_payload_min_size;
   byte m_payload_max_size;
   byte m_payload_crc;
+  byte m_receiveMode;
+  byte m_payloadLength;
   byte m_payload[PAYLOADSIZE];
+  bool m_signalSampled;
+  int m_rssi;
+  long m_fei;
+  int m_payloadRssi;
+  long m_payloadFei;
+  unsigned long m_syncMicros;
+  unsigned long m_syncCount;
+  unsigned long m_latencySum;
+  unsigned long m_latencyMax;
+  word m_latencyCount;
+  bool m_blind;
+  unsigned long m_blindSince;
+  unsigned long m_blindMicros;
+  unsigned long m_blindMillis;
+  unsigned long m_blindCount;
+  word m_lastTicks;
+  byte m_profile;
+  // RFM69 listen mode, idle and RX phase in 64 us units, 0 = from the data rate profile
+  bool m_listen;
+  byte m_listenIdle;
+  byte m_listenRx;
+  byte m_listenRssi;
+  unsigned long m_listenFrames;
+  unsigned long m_listenTimeouts;
+  unsigned long m_repeatsMerged;
+  unsigned long m_repeatsEvicted;
+  unsigned long m_profileSwitchMicros;
+  RepeatCandidate m_repeats[REPEAT_CANDIDATES];
+  // Configuration registers 0x00..0x4F of RFM69 and SX127x as last written
+  static const byte SHADOW_SIZE = 0x50;
+  byte m_shadow[SHADOW_SIZE];
+  unsigned long m_spiTransactions;
+  unsigned long m_spiPolls;
+  unsigned long m_frameTransactionStart;
+  unsigned long m_frameTransactionSum;
+  word m_frameTransactionCount;
+
+  static const byte RING_SIZE = 32;
+  static RFMxx *s_ringRadio;
+  static volatile byte s_ringHead;
+  static volatile byte s_ringTail;
+  static volatile byte s_ringOverflows;
+  static volatile byte s_ringData[RING_SIZE];
+  static volatile word s_ringTicks[RING_SIZE];
+  static volatile int8_t s_ringOffset[RING_SIZE];
+  static byte s_isrFrame[];
+  static byte s_isrLength;
+  static byte s_isrCrc;
 
   byte spi8(byte);
   unsigned short spi16(unsigned short value);
   byte ReadReg(byte addr);
   void WriteReg(byte addr, byte value);
+  void ReadBurst(byte addr, byte *data, byte length);
+  void WriteBurst(byte addr, const byte *data, byte length);
+  void Select();
+  void Deselect();
+  byte Transfer(byte value);
+  void SampleSignal();
+  void ReadSignal();
+  void StreamByte(byte bt);
+  void SetPayloadReady();
+  void MarkBlind();
+  void MarkListening();
+  bool RestartsAtOnce();
+  static void HandleInterrupt();
+  void ReceiveFromRing();
+  void EnableInterruptRing(bool enable);
+  void SetOpMode(byte mode);
+  byte GetListenIdle();
+  byte GetListenRx();
+  void WriteListenTiming();
+  void StartListen();
+  void LoadShadow();
+  void WriteTable(const byte *table);
+  void WaitReady();
+  RepeatCandidate *FindRepeat(byte *payload, byte payLoadSize);
+  void ReleaseRepeat(RepeatCandidate *candidate, byte *data, byte &length, byte &packetCount);
+  bool HasPendingRepeats();
   byte GetByteFromFifo();
   bool ClearFifo();
   void SendByte(byte data);
@@ -75,8 +217,10 @@ private:
 
 #ifdef USE_SX127x // use official semtech defines
 #include "sx1276Regs-Fsk.h"
+#define FifoHasData(flags2) (!((flags2) & RF_IRQFLAGS2_FIFOEMPTY))
 #else
 #include "RFM69.h"
+#define FifoHasData(flags2) ((flags2) & RF_IRQFLAGS2_FIFONOTEMPTY)
 #endif
 #endif
 
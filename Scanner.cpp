@@ -0,0 +1,286 @@
+#include "Scanner.h"
+#include "SensorBase.h"
+
+// Finding the frequency of the sensors of a new install. The sweep takes a burst of RSSI
+// samples at every 5 kHz step of the range and keeps the strongest one per bin of the
+// spectrum. Then the receiver dwells on the strongest peaks, counts the sync words and
+// decodes the frames, the FEI of a frame gives the centre frequency of its sensor.
+// At the end the receiver goes back to its frequency from before the scan.
+//
+//   [Scan done From:863000 To:870000 Bin:150 Floor:-104 Sweep:1240ms]
+//   SCAN Spectrum:__._..:_-=#=-_..._:.__
+//   SCAN Peak:868300 RSSI:-71 Syncs:14 Frames:3
+//   SCAN LaCrosse ID:12 Centre:868292 RSSI:-70 Count:3
+//
+// The spectrum has one character per bin, every level is 3 dB above the noise floor.
+
+#define SCANNER_STEP       5              // kHz, the resolution of SetFrequency
+#define SCANNER_SAMPLES    8              // RSSI samples per step
+#define SCANNER_SETTLE     100            // us for the PLL and the RSSI after a step
+#define SCANNER_DWELL      10000UL        // ms on each peak, LaCrosse sensors send every 4 seconds
+#define SCANNER_MARGIN     6              // dB above the noise floor for a peak
+#define SCANNER_MAX_RANGE  20000UL        // kHz
+
+static const char levels[] = "_.:-=+*#%@";
+
+Scanner::Scanner(RFMxx *rfm) {
+  m_rfm = rfm;
+  m_state = IDLE;
+  m_from = 0;
+  m_to = 0;
+  m_stepsPerBin = 1;
+  m_binCount = 0;
+  m_bin = 0;
+  m_restoreFrequency = 0;
+  m_sweepStart = 0;
+  m_sweepMillis = 0;
+  m_peakCount = 0;
+  m_peak = 0;
+  m_dwellStart = 0;
+  m_dwellSyncs = 0;
+  for (byte i = 0; i < SCANNER_SENSORS; i++) {
+    m_sensors[i].protocol = SensorBase::PROTOCOL_NONE;
+  }
+}
+
+bool Scanner::Start(unsigned long from, unsigned long to) {
+  // The RFM12B has no RSSI value, the listen mode no continuous RX
+  if (m_rfm->GetRadioType() == RFMxx::RFM12B || m_rfm->IsListening()) {
+    return false;
+  }
+  if (to <= from || to - from > SCANNER_MAX_RANGE) {
+    return false;
+  }
+  if (m_state == IDLE) {
+    m_restoreFrequency = m_rfm->GetFrequency();
+  }
+
+  m_from = from;
+  m_to = to;
+  word steps = (to - from) / SCANNER_STEP + 1;
+  m_stepsPerBin = (steps + SCANNER_BINS - 1) / SCANNER_BINS;
+  m_binCount = (steps + m_stepsPerBin - 1) / m_stepsPerBin;
+  m_bin = 0;
+  m_peakCount = 0;
+  for (byte i = 0; i < SCANNER_SENSORS; i++) {
+    m_sensors[i].protocol = SensorBase::PROTOCOL_NONE;
+  }
+  m_sweepStart = millis();
+  m_state = SWEEP;
+  return true;
+}
+
+void Scanner::Stop() {
+  if (m_state != IDLE) {
+    m_state = IDLE;
+    m_rfm->SetFrequency(m_restoreFrequency);
+    m_rfm->RestartReceiver(true);
+  }
+}
+
+bool Scanner::IsActive() {
+  return m_state != IDLE;
+}
+
+// One bin per call, the serial port and the other radios are served in between
+void Scanner::SweepBin() {
+  Bin *bin = &m_bins[m_bin];
+  bin->rssi = 255;
+  bin->step = 0;
+  for (word s = 0; s < m_stepsPerBin; s++) {
+    unsigned long kHz = m_from + ((unsigned long)m_bin * m_stepsPerBin + s) * SCANNER_STEP;
+    if (kHz > m_to) {
+      break;
+    }
+    m_rfm->SetFrequency(kHz);
+    m_rfm->RestartReceiver(true);
+    delayMicroseconds(SCANNER_SETTLE);
+    for (byte n = 0; n < SCANNER_SAMPLES; n++) {
+      byte rssi = -m_rfm->MeasureRssi();
+      if (rssi < bin->rssi) {
+        bin->rssi = rssi;
+        bin->step = s;
+      }
+    }
+  }
+}
+
+// The weakest bin is taken as the noise floor, in -dBm
+byte Scanner::GetFloor() {
+  byte floor = 0;
+  for (byte b = 0; b < m_binCount; b++) {
+    if (m_bins[b].rssi > floor) {
+      floor = m_bins[b].rssi;
+    }
+  }
+  return floor;
+}
+
+// The strongest local maxima above the noise floor, strongest first
+void Scanner::FindPeaks() {
+  byte floor = GetFloor();
+  m_peakCount = 0;
+  for (byte b = 0; b < m_binCount; b++) {
+    byte rssi = m_bins[b].rssi;
+    if (rssi + SCANNER_MARGIN > floor) {
+      continue;
+    }
+    if ((b > 0 && m_bins[b - 1].rssi < rssi) || (b + 1 < m_binCount && m_bins[b + 1].rssi <= rssi)) {
+      continue;
+    }
+
+    byte position = m_peakCount;
+    while (position > 0 && m_peaks[position - 1].rssi > rssi) {
+      if (position < SCANNER_PEAKS) {
+        m_peaks[position] = m_peaks[position - 1];
+      }
+      position--;
+    }
+    if (position >= SCANNER_PEAKS) {
+      continue;
+    }
+    Peak *peak = &m_peaks[position];
+    peak->frequency = m_from + ((unsigned long)b * m_stepsPerBin + m_bins[b].step) * SCANNER_STEP;
+    peak->rssi = rssi;
+    peak->syncs = 0;
+    peak->frames = 0;
+    if (m_peakCount < SCANNER_PEAKS) {
+      m_peakCount++;
+    }
+  }
+}
+
+void Scanner::StartDwell() {
+  m_rfm->SetFrequency(m_peaks[m_peak].frequency);
+  m_rfm->RestartReceiver(true);
+  m_dwellSyncs = m_rfm->GetSyncCount();
+  m_dwellStart = millis();
+  m_state = DWELL;
+}
+
+void Scanner::Finish() {
+  Stop();
+  Report();
+}
+
+void Scanner::Update(byte protocol, word id, int rssi, long fei) {
+  if (m_state != DWELL) {
+    return;
+  }
+  Peak *peak = &m_peaks[m_peak];
+  if (peak->frames < 255) {
+    peak->frames++;
+  }
+
+  unsigned long centre = m_rfm->GetFrequency() + fei / 1000;
+  Sensor *empty = NULL;
+  for (byte i = 0; i < SCANNER_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == protocol && sensor->id == id) {
+      // Running mean over the frames of the sensor, it may be heard on several peaks
+      sensor->centre = (sensor->centre * sensor->count + centre) / (sensor->count + 1);
+      if (rssi > sensor->rssi) {
+        sensor->rssi = rssi;
+      }
+      if (sensor->count < 255) {
+        sensor->count++;
+      }
+      return;
+    }
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE && empty == NULL) {
+      empty = sensor;
+    }
+  }
+  if (empty != NULL) {
+    empty->protocol = protocol;
+    empty->id = id;
+    empty->centre = centre;
+    empty->rssi = rssi;
+    empty->count = 1;
+  }
+}
+
+void Scanner::Handle() {
+  if (m_state == SWEEP) {
+    SweepBin();
+    if (++m_bin >= m_binCount) {
+      m_sweepMillis = millis() - m_sweepStart;
+      FindPeaks();
+      m_peak = 0;
+      if (m_peakCount == 0) {
+        Finish();
+      }
+      else {
+        StartDwell();
+      }
+    }
+  }
+  else if (m_state == DWELL && millis() - m_dwellStart >= SCANNER_DWELL) {
+    unsigned long syncs = m_rfm->GetSyncCount() - m_dwellSyncs;
+    m_peaks[m_peak].syncs = syncs > 0xFFFF ? 0xFFFF : syncs;
+    if (++m_peak >= m_peakCount) {
+      Finish();
+    }
+    else {
+      StartDwell();
+    }
+  }
+}
+
+void Scanner::Report() {
+  Serial.print(F("[Scan "));
+  Serial.print(m_state == SWEEP ? "sweep" : (m_state == DWELL ? "dwell" : "done"));
+  Serial.print(F(" From:"));
+  Serial.print(m_from);
+  Serial.print(F(" To:"));
+  Serial.print(m_to);
+  Serial.print(F(" Bin:"));
+  Serial.print(m_stepsPerBin * SCANNER_STEP);
+  if (m_state == SWEEP || m_binCount == 0) {
+    Serial.println(']');
+    return;
+  }
+  byte floor = GetFloor();
+  Serial.print(F(" Floor:-"));
+  Serial.print(floor);
+  Serial.print(F(" Sweep:"));
+  Serial.print(m_sweepMillis);
+  Serial.println(F("ms]"));
+
+  Serial.print(F("SCAN Spectrum:"));
+  for (byte b = 0; b < m_binCount; b++) {
+    byte level = (floor - m_bins[b].rssi) / 3;
+    Serial.print(levels[level < sizeof(levels) - 1 ? level : sizeof(levels) - 2]);
+  }
+  Serial.println();
+
+  for (byte p = 0; p < m_peakCount; p++) {
+    Serial.print(F("SCAN Peak:"));
+    Serial.print(m_peaks[p].frequency);
+    Serial.print(F(" RSSI:-"));
+    Serial.print(m_peaks[p].rssi);
+    Serial.print(F(" Syncs:"));
+    Serial.print(m_peaks[p].syncs);
+    Serial.print(F(" Frames:"));
+    Serial.print(m_peaks[p].frames);
+    Serial.println();
+  }
+
+  for (byte i = 0; i < SCANNER_SENSORS; i++) {
+    Sensor *sensor = &m_sensors[i];
+    if (sensor->protocol == SensorBase::PROTOCOL_NONE) {
+      continue;
+    }
+    Serial.print(F("SCAN "));
+    Serial.print(SensorBase::GetProtocolName(sensor->protocol));
+    Serial.print(F(" ID:"));
+    Serial.print(sensor->id, DEC);
+    Serial.print(F(" Centre:"));
+    Serial.print(sensor->centre);
+    Serial.print(F(" RSSI:"));
+    Serial.print(sensor->rssi);
+    Serial.print(F(" Count:"));
+    Serial.print(sensor->count, DEC);
+    Serial.println();
+  }
+}
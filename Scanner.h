@@ -0,0 +1,81 @@
+#ifndef _SCANNER_h
+#define _SCANNER_h
+
+#include "Arduino.h"
+#include "RFMxx.h"
+
+// The ATmega328 lacks the RAM for the scan, define USE_SCANNER to build it in anyway
+#ifdef ESP32
+#define USE_SCANNER
+#define SCANNER_BINS 200
+#define SCANNER_PEAKS 8
+#define SCANNER_SENSORS 16
+#else
+#define SCANNER_BINS 32
+#define SCANNER_PEAKS 3
+#define SCANNER_SENSORS 4
+#endif
+
+class Scanner {
+ private:
+   enum State {
+     IDLE,
+     SWEEP,
+     DWELL
+   };
+
+   struct Bin {
+     byte rssi;                   // strongest sample in -dBm
+     byte step;                   // 5 kHz step of the strongest sample within the bin
+   };
+
+   struct Peak {
+     unsigned long frequency;     // kHz
+     byte rssi;
+     word syncs;                  // sync words seen while dwelling on the peak
+     byte frames;                 // frames decoded while dwelling on the peak
+   };
+
+   struct Sensor {
+     byte protocol;
+     word id;
+     unsigned long centre;        // kHz, tuned frequency corrected by the FEI
+     int rssi;
+     byte count;
+   };
+
+   RFMxx *m_rfm;
+   State m_state;
+   unsigned long m_from;
+   unsigned long m_to;
+   word m_stepsPerBin;
+   byte m_binCount;
+   byte m_bin;
+   unsigned long m_restoreFrequency;
+   unsigned long m_sweepStart;
+   unsigned long m_sweepMillis;
+   Bin m_bins[SCANNER_BINS];
+   Peak m_peaks[SCANNER_PEAKS];
+   byte m_peakCount;
+   byte m_peak;
+   unsigned long m_dwellStart;
+   unsigned long m_dwellSyncs;
+   Sensor m_sensors[SCANNER_SENSORS];
+
+   void SweepBin();
+   void FindPeaks();
+   void StartDwell();
+   void Finish();
+   byte GetFloor();
+
+ public:
+   Scanner(RFMxx *rfm);
+   bool Start(unsigned long from, unsigned long to);
+   void Stop();
+   bool IsActive();
+   void Update(byte protocol, word id, int rssi, long fei);
+   void Handle();
+   void Report();
+};
+
+#endif
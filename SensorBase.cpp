@@ -1,6 +1,41 @@
 #include "SensorBase.h"
+#include "Aggregator.h"
+#include "DeltaReporter.h"
+#include "Clock.h"
 
 bool SensorBase::m_debug = false;
+byte SensorBase::m_optionalFields = 0;
+int SensorBase::m_rssi = 0;
+long SensorBase::m_fei = 0;
+byte SensorBase::m_source = 0;
+byte SensorBase::m_lastProtocol = PROTOCOL_NONE;
+word SensorBase::m_lastID = 0;
+bool SensorBase::m_correction = false;
+unsigned long SensorBase::m_corrections = 0;
+byte SensorBase::m_outputMode = OUTPUT_FRAMES;
+word SensorBase::m_valueMask = 0;
+float SensorBase::m_values[VALUE_COUNT];
+
+// CRC-8 0x31 syndrome of a single flipped bit -> distance of the bit from the end of the frame,
+// 0xFF if no single bit within 13 bytes gives this syndrome. The syndromes repeat after 127 bits.
+static const byte syndromeBits[256] PROGMEM = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x19, 0xFF, 0xFF, 0xFF, 0x5E, 0xFF, 0xFF, 0x1A, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3A, 0x5F, 0xFF, 0xFF, 0x4A, 0xFF, 0xFF, 0x1B, 0xFF, 0xFF, 0x22,
+  0xFF, 0xFF, 0xFF, 0x0F, 0xFF, 0x47, 0xFF, 0xFF, 0xFF, 0x12, 0x3B, 0xFF, 0x60, 0xFF, 0xFF, 0x35,
+  0xFF, 0x00, 0x4B, 0xFF, 0xFF, 0xFF, 0xFF, 0x0B, 0x1C, 0xFF, 0xFF, 0x2D, 0xFF, 0x06, 0x23, 0xFF,
+  0xFF, 0xFF, 0xFF, 0x04, 0xFF, 0x45, 0x10, 0xFF, 0xFF, 0x38, 0x48, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x63, 0x13, 0xFF, 0x3C, 0xFF, 0xFF, 0x28, 0x61, 0xFF, 0xFF, 0x41, 0xFF, 0x43, 0x36, 0xFF,
+  0xFF, 0x3E, 0x01, 0xFF, 0x4C, 0xFF, 0xFF, 0x58, 0xFF, 0xFF, 0xFF, 0x5B, 0xFF, 0x2A, 0x0C, 0xFF,
+  0x1D, 0xFF, 0xFF, 0x4F, 0xFF, 0x65, 0x2E, 0xFF, 0xFF, 0x15, 0x07, 0xFF, 0x24, 0xFF, 0xFF, 0x54,
+  0xFF, 0xFF, 0xFF, 0x0A, 0xFF, 0x2C, 0x05, 0xFF, 0xFF, 0x0E, 0x46, 0xFF, 0x11, 0xFF, 0xFF, 0x34,
+  0xFF, 0xFF, 0x39, 0xFF, 0x49, 0xFF, 0xFF, 0x21, 0xFF, 0xFF, 0xFF, 0x18, 0xFF, 0x5D, 0xFF, 0xFF,
+  0xFF, 0x4E, 0x64, 0xFF, 0x14, 0xFF, 0xFF, 0x53, 0x3D, 0xFF, 0xFF, 0x57, 0xFF, 0x5A, 0x29, 0xFF,
+  0x62, 0xFF, 0xFF, 0x27, 0xFF, 0x40, 0x42, 0xFF, 0xFF, 0x03, 0x44, 0xFF, 0x37, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x26, 0x3F, 0xFF, 0x02, 0xFF, 0xFF, 0xFF, 0x4D, 0xFF, 0xFF, 0x52, 0xFF, 0x56, 0x59, 0xFF,
+  0xFF, 0xFF, 0xFF, 0x20, 0xFF, 0x17, 0x5C, 0xFF, 0xFF, 0x09, 0x2B, 0xFF, 0x0D, 0xFF, 0xFF, 0x33,
+  0x1E, 0xFF, 0xFF, 0x31, 0xFF, 0x67, 0x50, 0xFF, 0xFF, 0x30, 0x66, 0xFF, 0x2F, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x1F, 0x16, 0xFF, 0x08, 0xFF, 0xFF, 0x32, 0x25, 0xFF, 0xFF, 0xFF, 0xFF, 0x51, 0x55, 0xFF,
+};
 
 byte SensorBase::UpdateCRC(byte res, uint8_t val) {
     for (int i = 0; i < 8; i++) {
@@ -27,6 +62,147 @@ void SensorBase::SetDebugMode(boolean mode) {
   m_debug = mode;
 }
 
+void SensorBase::SetOptionalFields(byte fields) {
+  m_optionalFields = fields;
+}
+
+byte SensorBase::GetOptionalFields() {
+  return m_optionalFields;
+}
+
+void SensorBase::SetSignal(int rssi, long fei) {
+  m_rssi = rssi;
+  m_fei = fei;
+}
+
+// The decoders register the sensor of each valid frame, so per sensor
+// bookkeeping (e.g. AFC) does not need to know the frame formats
+void SensorBase::SetLastSensor(byte protocol, word id) {
+  m_lastProtocol = protocol;
+  m_lastID = id;
+  m_valueMask = 0;
+}
+
+byte SensorBase::GetLastProtocol() {
+  return m_lastProtocol;
+}
+
+word SensorBase::GetLastID() {
+  return m_lastID;
+}
+
+void SensorBase::SetOutputMode(byte mode) {
+  m_outputMode = mode;
+}
+
+byte SensorBase::GetOutputMode() {
+  return m_outputMode;
+}
+
+// Besides their own output format the decoders report the measured values of
+// the last sensor in a common form, for the output modes that work on values
+void SensorBase::SetValue(byte value, float v) {
+  m_values[value] = v;
+  m_valueMask |= (word)1 << value;
+}
+
+// Hands the values to the output mode, returns true if the frame must not be displayed
+bool SensorBase::ForwardValues() {
+#ifdef USE_AGGREGATOR
+  if (m_outputMode == OUTPUT_AGGREGATE) {
+    Aggregator::Add(m_lastProtocol, m_lastID, m_valueMask, m_values);
+    return true;
+  }
+#endif
+#ifdef USE_DELTA_REPORTER
+  if (m_outputMode == OUTPUT_DELTA) {
+    DeltaReporter::Add(m_lastProtocol, m_lastID, m_valueMask, m_values);
+    return true;
+  }
+#endif
+  return false;
+}
+
+const __FlashStringHelper *SensorBase::GetValueName(byte value) {
+  switch (value) {
+  case VALUE_TEMPERATURE:
+    return F("Temp");
+  case VALUE_HUMIDITY:
+    return F("Hum");
+  case VALUE_WIND:
+    return F("Wind");
+  case VALUE_POWER:
+    return F("Power");
+  case VALUE_LEVEL:
+    return F("Level");
+  case VALUE_GUST:
+    return F("Gust");
+  case VALUE_RAIN:
+    return F("Rain");
+  case VALUE_BEARING:
+    return F("Dir");
+  case VALUE_VOLTAGE:
+    return F("Volt");
+  case VALUE_CURRENT:
+    return F("Curr");
+  case VALUE_ENERGY:
+    return F("Energy");
+  case VALUE_BATTERY:
+    return F("WeakBatt");
+  default:
+    return F("Unknown");
+  }
+}
+
+const __FlashStringHelper *SensorBase::GetProtocolName(byte protocol) {
+  switch (protocol) {
+  case PROTOCOL_LACROSSE:
+    return F("LaCrosse");
+  case PROTOCOL_LEVELSENDER:
+    return F("LevelSender");
+  case PROTOCOL_EMT7110:
+    return F("EMT7110");
+  case PROTOCOL_WT440XH:
+    return F("WT440XH");
+  case PROTOCOL_TX38IT:
+    return F("TX38IT");
+  case PROTOCOL_WH1080:
+    return F("WH1080");
+  case PROTOCOL_WS1600:
+    return F("WS1600");
+  default:
+    return F("Unknown");
+  }
+}
+
+void SensorBase::SetSource(byte radio) {
+  m_source = radio;
+}
+
+void SensorBase::DisplayOptionalFields() {
+  if (m_optionalFields & FIELD_SIGNAL) {
+    // RSSI is unknown (0) for the RFM12B
+    if (m_rssi != 0) {
+      Serial.print(F(" RSSI:"));
+      Serial.print(m_rssi);
+    }
+    Serial.print(F(" FEI:"));
+    Serial.print(m_fei);
+  }
+  if (m_optionalFields & FIELD_SOURCE) {
+    Serial.print(F(" R:"));
+    Serial.print(m_source, DEC);
+  }
+  DisplayTime();
+}
+
+void SensorBase::DisplayTime() {
+  if ((m_optionalFields & FIELD_TIME) && Clock::IsValid()) {
+    Serial.print(F(" Time:"));
+    Clock::Print();
+  }
+}
+
 void SensorBase::DisplayFrame(unsigned long &lastMillis, char *device, bool fIsValid, byte *data, byte frameLength) {
     unsigned long now = millis();
     char div[16];
@@ -38,20 +214,58 @@ void SensorBase::DisplayFrame(unsigned long &lastMillis, char *device, bool fIsV
     lastMillis = now;
 	// Show the raw data bytes
 	Serial.print(device);
-	Serial.print(" [");
+	Serial.print(F(" ["));
 	for (int i = 0; i < frameLength; i++) {
 	  Serial.print(data[i], HEX);
-	  Serial.print(" ");
+	  Serial.print(F(" "));
 	}
-	Serial.print("]");
+	Serial.print(F("]"));
 
 	// Check CRC
 	if (!fIsValid) {
-	  Serial.print(" CRC:WRONG");
+	  Serial.print(F(" CRC:WRONG"));
 	}
 	else {
-	  Serial.print(" CRC:OK");
+	  Serial.print(F(" CRC:OK"));
     }
+    DisplayOptionalFields();
 }
 
 
+
+void SensorBase::EnableCorrection(bool enable) {
+  m_correction = enable;
+}
+
+bool SensorBase::IsCorrectionEnabled() {
+  return m_correction;
+}
+
+// Copy the frame and flip the single bit its CRC syndrome points to. A bit in the first
+// nibble is never corrected, it tells the protocol.
+bool SensorBase::CorrectFrame(byte *data, byte *corrected, byte length) {
+  if (!m_correction) {
+    return false;
+  }
+  byte distance = pgm_read_byte(&syndromeBits[CalculateCRC(data, length)]);
+  if (distance >= length * 8) {
+    return false;
+  }
+  byte index = length - 1 - distance / 8;
+  byte mask = 1 << (distance % 8);
+  if (index == 0 && mask >= 0x10) {
+    return false;
+  }
+  memcpy(corrected, data, length);
+  corrected[index] ^= mask;
+  return true;
+}
+
+// The corrected frame decoded and passed the range checks
+void SensorBase::CountCorrection() {
+  m_corrections++;
+}
+
+unsigned long SensorBase::GetCorrections() {
+  return m_corrections;
+}
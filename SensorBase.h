@@ -5,13 +5,84 @@
 
 class SensorBase {
 public:
+  enum OptionalFields {
+    FIELD_SIGNAL = 1,
+    FIELD_SOURCE = 2,
+    FIELD_TIME = 4
+  };
+
+  enum Protocol {
+    PROTOCOL_NONE = 0,
+    PROTOCOL_LACROSSE,
+    PROTOCOL_LEVELSENDER,
+    PROTOCOL_EMT7110,
+    PROTOCOL_WT440XH,
+    PROTOCOL_TX38IT,
+    PROTOCOL_WH1080,
+    PROTOCOL_WS1600,
+    PROTOCOL_COUNT
+  };
+
+  enum Value {
+    VALUE_TEMPERATURE = 0,
+    VALUE_HUMIDITY,
+    VALUE_WIND,
+    VALUE_POWER,
+    VALUE_LEVEL,
+    VALUE_GUST,                   // the values from here on are not aggregated
+    VALUE_RAIN,
+    VALUE_BEARING,
+    VALUE_VOLTAGE,
+    VALUE_CURRENT,
+    VALUE_ENERGY,
+    VALUE_BATTERY,
+    VALUE_COUNT
+  };
+
+  enum OutputMode {
+    OUTPUT_FRAMES = 0,            // one line per frame
+    OUTPUT_AGGREGATE = 1,         // one summary line per sensor and window
+    OUTPUT_DELTA = 2              // only the values that changed
+  };
+
   static byte UpdateCRC(byte res, uint8_t val);
   static byte CalculateCRC(byte *data, byte len);
   static void SetDebugMode(boolean mode);
   static void DisplayFrame(unsigned long &lastMillis, char *device, bool fIsValid, byte *data, byte frameLength);
+  static void SetOptionalFields(byte fields);
+  static byte GetOptionalFields();
+  static void SetSignal(int rssi, long fei);
+  static void SetSource(byte radio);
+  static void DisplayOptionalFields();
+  static void DisplayTime();
+  static void SetLastSensor(byte protocol, word id);
+  static byte GetLastProtocol();
+  static word GetLastID();
+  static const __FlashStringHelper *GetProtocolName(byte protocol);
+  static void EnableCorrection(bool enable);
+  static bool IsCorrectionEnabled();
+  static bool CorrectFrame(byte *data, byte *corrected, byte length);
+  static void CountCorrection();
+  static unsigned long GetCorrections();
+  static void SetOutputMode(byte mode);
+  static byte GetOutputMode();
+  static void SetValue(byte value, float v);
+  static bool ForwardValues();
+  static const __FlashStringHelper *GetValueName(byte value);
 
 protected:
   static bool m_debug;
+  static byte m_optionalFields;
+  static int m_rssi;
+  static long m_fei;
+  static byte m_source;
+  static byte m_lastProtocol;
+  static word m_lastID;
+  static bool m_correction;
+  static unsigned long m_corrections;
+  static byte m_outputMode;
+  static word m_valueMask;
+  static float m_values[VALUE_COUNT];
 
 };
 
@@ -0,0 +1,223 @@
+#include "SensorFilter.h"
+#include "SensorBase.h"
+#include "Config.h"
+#include <EEPROM.h>
+
+// Neighbours' sensors must not reach the serial link. Every protocol has a list of IDs
+// that is either a deny or an allow list. Short IDs are bitmaps, so a lookup is one
+// bit test; the 16 bit EMT7110 IDs go into a small hash set.
+// The decoders ask right after the CRC check, before any output is formatted.
+
+#define FILTER_EMPTY 0xFFFF
+
+SensorFilter::Lists SensorFilter::m_lists;
+unsigned long SensorFilter::m_filtered = 0;
+
+void SensorFilter::ClearLists() {
+  memset(&m_lists, 0, sizeof(m_lists));
+  for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+    m_lists.emt7110[i] = FILTER_EMPTY;
+  }
+}
+
+void SensorFilter::Load() {
+#ifdef ESP32
+  EEPROM.begin(CONFIG_EEPROM_SIZE);
+#endif
+  if (EEPROM.read(FILTER_EEPROM_ADDRESS) == FILTER_EEPROM_MAGIC) {
+    EEPROM.get(FILTER_EEPROM_ADDRESS + 1, m_lists);
+  }
+  else {
+    ClearLists();
+  }
+}
+
+void SensorFilter::Save() {
+  // put() only writes the bytes that changed
+  EEPROM.put(FILTER_EEPROM_ADDRESS + 1, m_lists);
+  EEPROM.write(FILTER_EEPROM_ADDRESS, FILTER_EEPROM_MAGIC);
+#ifdef ESP32
+  EEPROM.commit();
+#endif
+}
+
+byte *SensorFilter::GetBitmap(byte protocol, word &bits) {
+  switch (protocol) {
+  case SensorBase::PROTOCOL_LACROSSE:
+    bits = sizeof(m_lists.laCrosse) * 8;
+    return m_lists.laCrosse;
+  case SensorBase::PROTOCOL_TX38IT:
+    bits = sizeof(m_lists.tx38it) * 8;
+    return m_lists.tx38it;
+  case SensorBase::PROTOCOL_WH1080:
+    bits = sizeof(m_lists.wh1080) * 8;
+    return m_lists.wh1080;
+  default:
+    bits = 0;
+    return NULL;
+  }
+}
+
+byte SensorFilter::GetSlot(word id) {
+  return ((byte)id ^ (byte)(id >> 8)) & (FILTER_EMT7110_SLOTS - 1);
+}
+
+bool SensorFilter::IsListed(byte protocol, word id) {
+  if (protocol == SensorBase::PROTOCOL_EMT7110) {
+    byte slot = GetSlot(id);
+    for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+      word entry = m_lists.emt7110[slot];
+      if (entry == id) {
+        return true;
+      }
+      if (entry == FILTER_EMPTY) {
+        return false;
+      }
+      slot = (slot + 1) & (FILTER_EMT7110_SLOTS - 1);
+    }
+    return false;
+  }
+
+  word bits;
+  byte *bitmap = GetBitmap(protocol, bits);
+  return bitmap != NULL && id < bits && (bitmap[id >> 3] & (1 << (id & 7)));
+}
+
+bool SensorFilter::IsFiltered(byte protocol, word id) {
+  bool allow = m_lists.modes & (1 << protocol);
+  if (IsListed(protocol, id) != allow) {
+    m_filtered++;
+    return true;
+  }
+  return false;
+}
+
+bool SensorFilter::Add(byte protocol, word id) {
+  if (IsListed(protocol, id)) {
+    return true;
+  }
+
+  if (protocol == SensorBase::PROTOCOL_EMT7110) {
+    if (id == FILTER_EMPTY) {
+      return false;
+    }
+    byte slot = GetSlot(id);
+    for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+      if (m_lists.emt7110[slot] == FILTER_EMPTY) {
+        m_lists.emt7110[slot] = id;
+        Save();
+        return true;
+      }
+      slot = (slot + 1) & (FILTER_EMT7110_SLOTS - 1);
+    }
+    return false;
+  }
+
+  word bits;
+  byte *bitmap = GetBitmap(protocol, bits);
+  if (bitmap == NULL || id >= bits) {
+    return false;
+  }
+  bitmap[id >> 3] |= 1 << (id & 7);
+  Save();
+  return true;
+}
+
+void SensorFilter::Remove(byte protocol, word id) {
+  if (!IsListed(protocol, id)) {
+    return;
+  }
+
+  if (protocol == SensorBase::PROTOCOL_EMT7110) {
+    // Insert the others again, so no probe sequence ends at the hole
+    word ids[FILTER_EMT7110_SLOTS];
+    memcpy(ids, m_lists.emt7110, sizeof(ids));
+    for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+      m_lists.emt7110[i] = FILTER_EMPTY;
+    }
+    for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+      if (ids[i] != FILTER_EMPTY && ids[i] != id) {
+        byte slot = GetSlot(ids[i]);
+        while (m_lists.emt7110[slot] != FILTER_EMPTY) {
+          slot = (slot + 1) & (FILTER_EMT7110_SLOTS - 1);
+        }
+        m_lists.emt7110[slot] = ids[i];
+      }
+    }
+  }
+  else {
+    word bits;
+    byte *bitmap = GetBitmap(protocol, bits);
+    bitmap[id >> 3] &= ~(1 << (id & 7));
+  }
+  Save();
+}
+
+void SensorFilter::SetMode(byte protocol, byte mode) {
+  if (protocol >= 8) {
+    return;
+  }
+  if (mode == MODE_ALLOW) {
+    m_lists.modes |= 1 << protocol;
+  }
+  else {
+    m_lists.modes &= ~(1 << protocol);
+  }
+  Save();
+}
+
+void SensorFilter::Clear(byte protocol) {
+  if (protocol == SensorBase::PROTOCOL_EMT7110) {
+    for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+      m_lists.emt7110[i] = FILTER_EMPTY;
+    }
+  }
+  else {
+    word bits;
+    byte *bitmap = GetBitmap(protocol, bits);
+    if (bitmap != NULL) {
+      memset(bitmap, 0, bits / 8);
+    }
+  }
+  m_lists.modes &= ~(1 << protocol);
+  Save();
+}
+
+unsigned long SensorFilter::GetFilteredCount() {
+  return m_filtered;
+}
+
+void SensorFilter::Report() {
+  Serial.print(F("[Filter Filtered:"));
+  Serial.print(m_filtered);
+  Serial.println(']');
+
+  const byte protocols[] = { SensorBase::PROTOCOL_LACROSSE, SensorBase::PROTOCOL_EMT7110, SensorBase::PROTOCOL_TX38IT, SensorBase::PROTOCOL_WH1080 };
+  for (byte p = 0; p < sizeof(protocols); p++) {
+    byte protocol = protocols[p];
+    Serial.print(F("Filter "));
+    Serial.print(SensorBase::GetProtocolName(protocol));
+    Serial.print(F(" Mode:"));
+    Serial.print(m_lists.modes & (1 << protocol) ? "Allow" : "Deny");
+    Serial.print(F(" IDs:"));
+    if (protocol == SensorBase::PROTOCOL_EMT7110) {
+      for (byte i = 0; i < FILTER_EMT7110_SLOTS; i++) {
+        if (m_lists.emt7110[i] != FILTER_EMPTY) {
+          Serial.print(m_lists.emt7110[i], DEC);
+          Serial.print(' ');
+        }
+      }
+    }
+    else {
+      word bits;
+      GetBitmap(protocol, bits);
+      for (word id = 0; id < bits; id++) {
+        if (IsListed(protocol, id)) {
+          Serial.print(id, DEC);
+          Serial.print(' ');
+        }
+      }
+    }
+    Serial.println();
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef _SENSORFILTER_h
+#define _SENSORFILTER_h
+
+#include "Arduino.h"
+
+#define FILTER_EMT7110_SLOTS  8                     // power of two
+#define FILTER_EEPROM_ADDRESS 0
+#define FILTER_EEPROM_MAGIC   0xF1
+
+class SensorFilter {
+public:
+  enum Mode {
+    MODE_DENY = 0,                // listed IDs are dropped
+    MODE_ALLOW = 1                // only listed IDs pass
+  };
+
+  static void Load();
+  static void Save();
+  static bool IsFiltered(byte protocol, word id);
+  static bool Add(byte protocol, word id);
+  static void Remove(byte protocol, word id);
+  static void SetMode(byte protocol, byte mode);
+  static void Clear(byte protocol);
+  static void Report();
+  static unsigned long GetFilteredCount();
+
+private:
+  struct Lists {
+    byte modes;                   // bit per protocol, set = allow list
+    byte laCrosse[8];             // 6 bit sensor IDs
+    byte tx38it[8];               // 6 bit sensor IDs
+    byte wh1080[32];              // 8 bit station IDs
+    word emt7110[FILTER_EMT7110_SLOTS];  // 16 bit IDs, open addressing
+  };
+
+  static Lists m_lists;
+  static unsigned long m_filtered;
+
+  static byte *GetBitmap(byte protocol, word &bits);
+  static bool IsListed(byte protocol, word id);
+  static byte GetSlot(word id);
+  static void ClearLists();
+};
+
+#endif
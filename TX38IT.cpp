@@ -1,4 +1,5 @@
 #include "TX38IT.h"
+#include "SensorFilter.h"
 
 /*
 * Technoline TX38-IT 17.241 868.3 MHz
@@ -167,24 +168,7 @@ String TX38IT::GetFhemDataString(struct Frame *frame) {
 }
 
 bool TX38IT::DisplayFrame(byte *data, struct TX38IT::Frame &frame, bool fOnlyIfValid) {
-  byte filter[5];
-  filter[0] = 0;
-  filter[1] = 0;
-  filter[2] = 0;
-  filter[3] = 0;
-  filter[4] = 0;
-
-  bool hideIt = false;
-  for (int f = 0; f < 5; f++) {
-    if (frame.ID == filter[f]) {
-      hideIt = true;
-      break;
-    }
-  }
-
-  if (!hideIt && fOnlyIfValid && !frame.IsValid) {
-	  hideIt = true;
-  }
+  bool hideIt = fOnlyIfValid && !frame.IsValid;
 
   if (!hideIt) {
     // MilliSeconds, raw data and crc ok
@@ -193,27 +177,27 @@ bool TX38IT::DisplayFrame(byte *data, struct TX38IT::Frame &frame, bool fOnlyIfV
 
     if (frame.IsValid) {
       // Start
-      Serial.print(" S:");
+      Serial.print(F(" S:"));
       Serial.print(frame.Header, DEC);
 
       // Sensor ID
-      Serial.print(" ID:");
+      Serial.print(F(" ID:"));
       Serial.print(frame.ID, DEC);
 
       // New battery flag
-      Serial.print(" NewBatt:");
+      Serial.print(F(" NewBatt:"));
       Serial.print(frame.NewBatteryFlag, DEC);
 
       // Weak battery flag
-      Serial.print(" WeakBatt:");
+      Serial.print(F(" WeakBatt:"));
       Serial.print(frame.WeakBatteryFlag, DEC);
 
       // Temperature
-      Serial.print(" Temp:");
+      Serial.print(F(" Temp:"));
       Serial.print(frame.Temperature);
 
       // CRC
-      Serial.print(" CRC:");
+      Serial.print(F(" CRC:"));
       Serial.print(frame.CRC, DEC);
     }
 
@@ -233,11 +217,25 @@ bool TX38IT::TryHandleData(byte *data, bool fFhemDisplay) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
+      if (SensorFilter::IsFiltered(PROTOCOL_TX38IT, frame.ID)) {
+        return true;
+      }
+      SetLastSensor(PROTOCOL_TX38IT, frame.ID);
+      SetValue(VALUE_TEMPERATURE, frame.Temperature);
+      if (frame.Humidity <= 100) {
+        SetValue(VALUE_HUMIDITY, frame.Humidity);
+      }
+      SetValue(VALUE_BATTERY, frame.WeakBatteryFlag);
+      if (ForwardValues()) {
+        return true;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
           return fhemString.length() > 0;
   	     }
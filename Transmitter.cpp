@@ -19,6 +19,22 @@ void Transmitter::Enable(bool enabled){
   m_enabled = enabled;
 }
 
+bool Transmitter::IsEnabled() {
+  return m_enabled;
+}
+
+byte Transmitter::GetId() {
+  return m_id;
+}
+
+word Transmitter::GetInterval() {
+  return m_interval;
+}
+
+unsigned long Transmitter::GetDataRate() {
+  return m_dataRate;
+}
+
 bool Transmitter::Transmit() {
   bool result = false;
 
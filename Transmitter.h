@@ -22,6 +22,10 @@ class Transmitter {
  public:
    Transmitter(RFMxx *rfm);
    void Enable(bool enabled);
+   bool IsEnabled();
+   byte GetId();
+   word GetInterval();
+   unsigned long GetDataRate();
    bool Transmit();
    void SetParameters(byte id, word interval, bool newBatteryFlag, unsigned long newBatteryFlagResetTime, unsigned long dataRate);
    void SetValues(float temperature, byte humidity);
@@ -1,9 +1,6 @@
 #include "WH1080.h"
-#if ARDUINO >= 100
-#include <TimeLib.h>
-#else
-#include <Time.h>
-#endif
+#include "SensorFilter.h"
+#include "Clock.h"
 /// FSK weather station receiver
 /// Receive packets echoes to serial.
 /// Updates DCF77 time.
@@ -68,6 +65,15 @@
  * The DCF code is transmitted five times with 48 second intervals between 3-6 minutes past a new hour. The sensor data transmission stops in the 59th minute. Then there are no transmissions for three minutes, apparently to be noise free to acquire the DCF77 signal. On similar OOK weather stations the DCF77 signal is only transmitted every two hours.
  */
 
+// Also taken by the WS1600, one copy of the names in RAM
+static const char *const compass[] = {"N  ", "NNE", "NE ", "ENE", "E  ", "ESE", "SE ", "SSE", "S  ", "SSW", "SW ", "WSW", "W  ", "WNW", "NW ", "NNW"};
+
+byte WH1080::m_votes[VOTE_COPIES][LEN_MAX];
+byte WH1080::m_voteWeights[VOTE_COPIES];
+byte WH1080::m_voteCount = 0;
+unsigned long WH1080::m_voteStart = 0;
+unsigned long WH1080::m_votedFrames = 0;
+
 byte WH1080::CalculateCRC(byte data[], byte frameLength) {
   return SensorBase::CalculateCRC(data, frameLength - 1);
 }
@@ -89,7 +95,6 @@ byte WH1080::DecodeFrame(byte *bytes, struct Frame *frame) {
   if (!frame->IsValid) {
 	  return 0;
   }
-    static char *compass[] = {"N  ", "NNE", "NE ", "ENE", "E  ", "ESE", "SE ", "SSE", "S  ", "SSW", "SW ", "WSW", "W  ", "WNW", "NW ", "NNW"};
     uint8_t windbearing = 0;
     byte status= 0;
     // station id
@@ -128,7 +133,7 @@ byte WH1080::DecodeFrame(byte *bytes, struct Frame *frame) {
   frame->Unknown = unknown;
   frame->Rain = rain;
   frame->Status = status;
-  frame->WindBearing = compass[windbearing];
+  frame->WindBearing = GetWindBearing(windbearing);
   return frame->frameLength;
 }
 
@@ -173,30 +178,14 @@ void printDouble( double val, byte precision){
   Serial.print(ascii);
 }
 
-static void timestamp(bool fLong=false)
-{
-	if (fLong) {
-	  Serial.print(year());
-	  Serial.print("-");
-	  printDigits(month());
-	  Serial.print("-");
-	  printDigits(day());
-	  Serial.print(" ");
-  }
-  printDigits(hour());
-  Serial.print(":");
-  printDigits(minute());
-  Serial.print(":");
-  printDigits(second());
-  Serial.print(" ");
-}
-
 static void update_time(uint8_t* tbuf) {
   static unsigned long lastMillis;
+  Clock::Set(BCD2bin(tbuf[5]), BCD2bin(tbuf[6] & 0x1F), BCD2bin(tbuf[7]), BCD2bin(tbuf[2] & 0x3F), BCD2bin(tbuf[3]), BCD2bin(tbuf[4]));
   SensorBase::DisplayFrame(lastMillis, "WH1080Time", true, tbuf, WH1080::FRAME_LENGTH);
-  Serial.print(' ');
-  setTime(BCD2bin(tbuf[2] & 0x3F),BCD2bin(tbuf[3]),BCD2bin(tbuf[4]),BCD2bin(tbuf[7]),BCD2bin(tbuf[6] & 0x1F),BCD2bin(tbuf[5]));
-  timestamp(true);
+  if (!(SensorBase::GetOptionalFields() & SensorBase::FIELD_TIME)) {
+    Serial.print(F(" Time:"));
+    Clock::Print();
+  }
   Serial.println();
 }
 
@@ -276,45 +265,45 @@ byte WH1080::DisplayFrame(byte *data,  byte packetCount, struct Frame *frame, bo
 
     if (frame->IsValid) {
       // Repeat/Package count
-      Serial.print(" #:");
+      Serial.print(F(" #:"));
       Serial.print(packetCount, DEC);
 
       // Start
-      Serial.print(" S:");
+      Serial.print(F(" S:"));
       Serial.print(frame->Header, HEX);
 
       // Sensor ID
-      Serial.print(" ID:");
+      Serial.print(F(" ID:"));
       Serial.print(frame->ID, HEX);
 
       // Temperature
-      Serial.print(" Temp:");
+      Serial.print(F(" Temp:"));
       printDouble(frame->Temperature);
 
       // Humidity
-      Serial.print(" Hum:");
+      Serial.print(F(" Hum:"));
       Serial.print(frame->Humidity, DEC);
 
-      Serial.print(" WindSpeed:");
+      Serial.print(F(" WindSpeed:"));
       printDouble(frame->WindSpeed);
 
-      Serial.print(" WindGust:");
+      Serial.print(F(" WindGust:"));
       printDouble(frame->WindGust);
 
-      Serial.print(" Unknown:");
+      Serial.print(F(" Unknown:"));
       Serial.print(frame->Unknown, HEX);
 
-      Serial.print(" Rain:");
+      Serial.print(F(" Rain:"));
       printDouble(frame->Rain);
 
-      Serial.print(" Status:");
+      Serial.print(F(" Status:"));
       Serial.print(frame->Status, HEX);
 
-      Serial.print(" WindBearing:");
+      Serial.print(F(" WindBearing:"));
       Serial.print(frame->WindBearing);
 
       // CRC
-      Serial.print(" CRC:");
+      Serial.print(F(" CRC:"));
       Serial.print(frame->CRC, HEX);
     }
 
@@ -365,11 +354,29 @@ byte WH1080::TryHandleData(byte *data, byte packetCount, bool fFhemDisplay) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
+      m_voteCount = 0;
+      if (SensorFilter::IsFiltered(PROTOCOL_WH1080, frame.ID)) {
+        return frameLength;
+      }
+      SetLastSensor(PROTOCOL_WH1080, frame.ID);
+      SetValue(VALUE_TEMPERATURE, frame.Temperature);
+      SetValue(VALUE_HUMIDITY, frame.Humidity);
+      SetValue(VALUE_WIND, frame.WindSpeed);
+      SetValue(VALUE_GUST, frame.WindGust);
+      SetValue(VALUE_RAIN, frame.Rain);
+      if (frameLength == FRAME_LENGTH) {
+        SetValue(VALUE_BEARING, (data[8] & 0x0F) * 22.5);
+      }
+      if (ForwardValues()) {
+        return frameLength;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
           return (fhemString.length() > 0) ? frameLength : 0;
   	     }
@@ -379,9 +386,83 @@ byte WH1080::TryHandleData(byte *data, byte packetCount, bool fFhemDisplay) {
     }
   }
   else if (CalculateCRC(data) == data[frameLength - 1]) {
+	  m_voteCount = 0;
 	  update_time(data);
 	  return frameLength;
   }
   return 0;
 }
 
+
+// Number of bits in which two copies differ
+byte WH1080::GetDistance(byte *a, byte *b) {
+  byte distance = 0;
+  for (byte i = 0; i < LEN_MAX; i++) {
+    for (byte bits = a[i] ^ b[i]; bits; bits &= bits - 1) {
+      distance++;
+    }
+  }
+  return distance;
+}
+
+// Keep a copy of a burst that did not decode, packetCount identical copies count as that many votes.
+// A copy too far from the first one is taken as another frame and starts a new vote.
+void WH1080::AddRepeat(byte *data, byte packetCount) {
+  if (m_voteCount > 0 && (millis() - m_voteStart > 1000 || (m_votes[0][0] & 0xF0) != (data[0] & 0xF0)
+    || GetDistance(m_votes[0], data) > VOTE_MAX_DISTANCE)) {
+    m_voteCount = 0;
+  }
+  if (m_voteCount == 0) {
+    m_voteStart = millis();
+  }
+  if (m_voteCount < VOTE_COPIES) {
+    memcpy(m_votes[m_voteCount], data, LEN_MAX);
+    m_voteWeights[m_voteCount] = packetCount > 0 ? packetCount : 1;
+    m_voteCount++;
+  }
+}
+
+// Every bit takes the value of the majority of the copies. With at least three votes a
+// single bit error per copy is outvoted as long as the copies fail at different bits.
+byte WH1080::VoteRepeats(byte *frame, byte &packetCount) {
+  byte startNibble = m_votes[0][0] >> 4;
+  byte frameLength = (startNibble == 0x5 || startNibble == 0x6) ? LEN_WS3000 : LEN_WS4000;
+  byte votes = 0;
+  for (byte c = 0; c < m_voteCount; c++) {
+    votes += m_voteWeights[c];
+  }
+  if (votes < 3) {
+    return 0;
+  }
+
+  for (byte i = 0; i < frameLength; i++) {
+    frame[i] = 0;
+    for (byte mask = 0x80; mask; mask >>= 1) {
+      byte ones = 0;
+      for (byte c = 0; c < m_voteCount; c++) {
+        if (m_votes[c][i] & mask) {
+          ones += m_voteWeights[c];
+        }
+      }
+      if (ones * 2 > votes) {
+        frame[i] |= mask;
+      }
+    }
+  }
+
+  if (CalculateCRC(frame, frameLength) != frame[frameLength - 1]) {
+    return 0;
+  }
+  m_voteCount = 0;
+  m_votedFrames++;
+  packetCount = votes;
+  return frameLength;
+}
+
+unsigned long WH1080::GetVotedFrames() {
+  return m_votedFrames;
+}
+
+const char *WH1080::GetWindBearing(byte direction) {
+  return compass[direction & 0x0F];
+}
@@ -23,7 +23,7 @@ public:
     byte  Unknown;
     double Rain;
     byte  Status;
-    char *WindBearing;
+    const char *WindBearing;
     byte  CRC;
     bool  IsValid;
     byte frameLength;
@@ -36,7 +36,21 @@ public:
   static void AnalyzeFrame(byte *data, byte packetCount, bool fOnlyIfValid = false);
   static byte TryHandleData(byte *data, byte packetCount, bool fFhemDisplay = true);
   static String GetFhemDataString(struct WH1080::Frame *frame);
-
+  static void AddRepeat(byte *data, byte packetCount);
+  static byte VoteRepeats(byte *frame, byte &packetCount);
+  static unsigned long GetVotedFrames();
+  static const char *GetWindBearing(byte direction);
+
+private:
+  static const byte VOTE_COPIES = 6;
+  static const byte VOTE_MAX_DISTANCE = 8;          // bits a copy of the same frame may differ in
+  static byte m_votes[VOTE_COPIES][LEN_MAX];
+  static byte m_voteWeights[VOTE_COPIES];
+  static byte m_voteCount;
+  static unsigned long m_voteStart;
+  static unsigned long m_votedFrames;
+
+  static byte GetDistance(byte *a, byte *b);
 };
 
 void printDigits(int digits);
@@ -39,6 +39,10 @@ a1250444109120003808401b89 00
 Temp  044 Humi 91 Rain 000 Wind 028  Dir 180 Gust 097  ( 4.4 °C, 91 %rH, no rain, wind 2.8 km/h from south, gust 9.7 km/h)
 */
 
+
+WS1600::Station WS1600::m_stations[WS1600_STATIONS];
+word WS1600::m_cadence = 0;
+
 byte WS1600::CalculateCRC(byte data[], byte frameLength) {
   return SensorBase::CalculateCRC(data, frameLength - 1);
 }
@@ -48,6 +52,14 @@ byte WS1600::DecodeFrame(byte *bytes, struct WS1600::Frame *frame) {
     uint8_t dataSets = sbuf[1] & 0xF;
   frame->IsValid = true;
   frame->Header = (bytes[0] & 0xF0) >> 4;
+  frame->DataSets = 0;
+  frame->Fresh = 0;
+  if (dataSets > DATASETS_MAX) {
+    // More quartets than a frame can carry, the count itself is damaged
+    frame->frameLength = FRAME_LENGTH;
+    frame->IsValid = false;
+    return 0;
+  }
   frame->frameLength = dataSets * 2 + 2 + 1;
 
   frame->CRC = bytes[frame->frameLength-1];
@@ -60,60 +72,67 @@ byte WS1600::DecodeFrame(byte *bytes, struct WS1600::Frame *frame) {
   if (!frame->IsValid) {
 	  return 0;
   }
-    static char *compass[] = {"N  ", "NNE", "NE ", "ENE", "E  ", "ESE", "SE ", "SSE", "S  ", "SSW", "SW ", "WSW", "W  ", "WNW", "NW ", "NNW"};
-    static char *sensors[] = {"Temp", "Hum ", "Rain", "Wind", "Gust"};
+    static const char *sensors[] = {"Temp", "Hum ", "Rain", "Wind", "Gust"};
     uint8_t windbearing = 0;
     // station id
-    uint8_t stationid = ((sbuf[0] & 0x0F) << 6) | ((sbuf[1] & 0xC0) >>6);
-    int8_t temp = 0;
-    int8_t tempDeci = 0;
+    uint16_t stationid = ((sbuf[0] & 0x0F) << 6) | ((sbuf[1] & 0xC0) >>6);
     //humidity
     uint8_t humidity = 0;
     //wind speed
     uint8_t windspeed = 0;
     //wind gust
-    uint8_t windgust = 0;
+    uint16_t windgust = 0;
     //rainfall
     uint16_t rain = 0;
 
+    // A quartet is only taken if its value is within the bounds of the sensor
     for (byte i = 0; i < dataSets; i++) {
 		byte j = 2 + i*2;
 		byte sensorType = (sbuf[j] & 0xF0) >> 4;
+		frame->SensorType[i] = sensorType < 5 ? sensors[sensorType] : "Unknown";
 		switch (sensorType) { // e.g. a 5a 5 0 628 1 033 2 000 3 e00 4 000 bd
 			case 0:	//  0: temperature, 3 nibbles bcd coded tenth of °c plus 400 (here 628-400 = 22.8°C)
-				temp = BCD2bin(sbuf[j] & 0x0F) * 10 + BCD2bin((sbuf[j + 1] & 0xF0)>>4);
-				temp = temp;
-				tempDeci = BCD2bin((sbuf[j + 1] & 0x0F));
-				frame->SensorType[i] = sensors[sensorType];
-			    frame->Temperature = ((temp * 10 + tempDeci) - 400) / 10;
+				if ((sbuf[j] & 0x0F) <= 9 && (sbuf[j + 1] >> 4) <= 9 && (sbuf[j + 1] & 0x0F) <= 9) {
+					int temp = BCD2bin(sbuf[j] & 0x0F) * 100 + BCD2bin(sbuf[j + 1]) - 400;
+					if (temp >= -400 && temp < 600) {
+						frame->Temperature = temp / 10.0;
+						frame->Fresh |= 1 << QUARTET_TEMPERATURE;
+					}
+				}
 				break;
 			case 1: // 1: humidity, 3 nibbles bcd coded (here 33 %rH), meaning of 1st nibble still unclear
-				humidity = BCD2bin(sbuf[j + 1]);
-				frame->SensorType[i] = sensors[sensorType];
-			    frame->Humidity = humidity;
+				if ((sbuf[j + 1] >> 4) <= 9 && (sbuf[j + 1] & 0x0F) <= 9) {
+					humidity = BCD2bin(sbuf[j + 1]);
+					frame->Humidity = humidity;
+					frame->Fresh |= 1 << QUARTET_HUMIDITY;
+				}
 				break;
-			case 2: // 2: rain, 3 nibbles, counter of contact closures
-				rain = ((sbuf[j] & 0x0F) + (sbuf[j + 1]) * 100);
-				frame->SensorType[i] = sensors[sensorType];
-				frame->Rain = rain;
+			case 2: // 2: rain, 3 nibbles, counter of contact closures, the first nibble counts up to 99
+				if ((sbuf[j] & 0x0F) <= 9) {
+					rain = ((sbuf[j] & 0x0F) + (sbuf[j + 1]) * 100);
+					frame->Rain = rain;
+					frame->Fresh |= 1 << QUARTET_RAIN;
+				}
 				break;
 			case 3:	//3: wind, first nibble direction of wind vane (multiply by 22.5 to obtain degrees,
     				// here 0xe*22.5 = 315 degrees)
 					// next two nibbles wind speed in m per sec (i.e. no more than 255 m/s; 9th bit still not found)
 				windbearing = (sbuf[j] & 0x0F);
 				windspeed = (sbuf[j + 1]);
-				frame->SensorType[i] = sensors[sensorType];
-			    frame->WindSpeed = windspeed;
-			    frame->WindBearing = compass[windbearing];
+				if (windspeed < 254) {
+					frame->WindSpeed = windspeed;
+					frame->WindBearing = WH1080::GetWindBearing(windbearing);
+					frame->WindDirection = windbearing;
+					frame->Fresh |= 1 << QUARTET_WIND;
+				}
 				break;
 			case 4: // 4: gust, speed in m per sec (yes, TX23 sensor does measure gusts and data are transmitted
     				// but not displayed by WS1600), number of significant nibbles still unclear
 				windgust = ((sbuf[j] & 0x0F) * 256 + (sbuf[j + 1]));
-				frame->SensorType[i] = sensors[sensorType];
-			    frame->WindGust = windgust;
-				break;
-			default:
-				frame->SensorType[i] = "Unkown";
+				if (windgust < 254) {
+					frame->WindGust = windgust;
+					frame->Fresh |= 1 << QUARTET_GUST;
+				}
 				break;
 		}
 
@@ -139,6 +158,12 @@ String WS1600::GetFhemDataString(struct Frame *frame) {
   // |  |------------------- fix "9"
   // |---------------------- fix "OK"
 
+  // Only complete records, temperature and humidity may come in different frames
+  byte needed = (1 << QUARTET_TEMPERATURE) | (1 << QUARTET_HUMIDITY);
+  if ((frame->Fresh & needed) != needed) {
+    return "";
+  }
+
   String pBuf;
   pBuf += "OK WS1600 ";
   pBuf += frame->ID;
@@ -198,52 +223,58 @@ byte WS1600::DisplayFrame(byte *data, struct Frame *frame, bool fOnlyIfValid) {
 
     if (frame->IsValid) {
       // Start
-      Serial.print(" S:");
+      Serial.print(F(" S:"));
       Serial.print(frame->Header, HEX);
 
 
       // Sensor ID
-      Serial.print(" ID:");
+      Serial.print(F(" ID:"));
       Serial.print(frame->ID, HEX);
 
 		// datasets
-	  Serial.print(" Datasets:");
+	  Serial.print(F(" Datasets:"));
       Serial.print(frame->DataSets, DEC);
 
-      // Temperature
-      Serial.print(" Temp:");
-      printDouble(frame->Temperature);
-
-      // Humidity
-      Serial.print(" Hum:");
-      Serial.print(frame->Humidity, DEC);
-
-      Serial.print(" WindSpeed:");
-      if (frame->WindSpeed < 254.0) {
-      	printDouble(frame->WindSpeed);
-	  }
-	  else {
-		  Serial.print("-1");
-	  }
-
-      Serial.print(" WindGust:");
-      printDouble(frame->WindGust);
-
-      Serial.print(" Rain:");
-      printDouble(frame->Rain);
-
-      Serial.print(" WindBearing:");
-      Serial.print(frame->WindBearing);
-
-	  Serial.print(" Sensors:[");
+      // Values of the station record, missing if not received lately
+      if (frame->Fresh & (1 << QUARTET_TEMPERATURE)) {
+        Serial.print(F(" Temp:"));
+        printDouble(frame->Temperature);
+      }
+
+      if (frame->Fresh & (1 << QUARTET_HUMIDITY)) {
+        Serial.print(F(" Hum:"));
+        Serial.print(frame->Humidity, DEC);
+      }
+
+      if (frame->Fresh & (1 << QUARTET_WIND)) {
+        Serial.print(F(" WindSpeed:"));
+        printDouble(frame->WindSpeed);
+      }
+
+      if (frame->Fresh & (1 << QUARTET_GUST)) {
+        Serial.print(F(" WindGust:"));
+        printDouble(frame->WindGust);
+      }
+
+      if (frame->Fresh & (1 << QUARTET_RAIN)) {
+        Serial.print(F(" Rain:"));
+        printDouble(frame->Rain);
+      }
+
+      if (frame->Fresh & (1 << QUARTET_WIND)) {
+        Serial.print(F(" WindBearing:"));
+        Serial.print(frame->WindBearing);
+      }
+
+	  Serial.print(F(" Sensors:["));
 		for (byte i = 0; i < frame->DataSets; i++) {
 			if (i > 0) {
-				Serial.print(", ");
+				Serial.print(F(", "));
 			}
 		  Serial.print(frame->SensorType[i]);
 		}
       // CRC
-      Serial.print("] CRC:");
+      Serial.print(F("] CRC:"));
       Serial.print(frame->CRC, HEX);
     }
 
@@ -259,17 +290,167 @@ void WS1600::AnalyzeFrame(byte *data, bool fOnlyIfValid) {
   frameLength = DisplayFrame(data, &frame, fOnlyIfValid);
 }
 
+// The number of quartets must stay the same and every quartet needs a known sensor type.
+// The rain counter only counts up, by a few closures from the value known of the station.
+bool WS1600::IsPlausible(byte *data, byte *corrected) {
+  byte dataSets = corrected[1] & 0x0F;
+  if (dataSets != (data[1] & 0x0F)) {
+    return false;
+  }
+  word id = ((corrected[0] & 0x0F) << 6) | ((corrected[1] & 0xC0) >> 6);
+  for (byte i = 0; i < dataSets; i++) {
+    byte *quartet = &corrected[2 + i * 2];
+    if ((quartet[0] >> 4) > 4) {
+      return false;
+    }
+    if ((quartet[0] >> 4) == QUARTET_RAIN) {
+      if ((quartet[0] & 0x0F) > 9) {
+        return false;
+      }
+      float rain = (quartet[0] & 0x0F) + quartet[1] * 100;
+      for (byte s = 0; s < WS1600_STATIONS; s++) {
+        Station *station = &m_stations[s];
+        if ((station->known & (1 << QUARTET_RAIN)) && station->id == id
+          && (rain < station->rain || rain - station->rain > WS1600_RAIN_STEP)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void WS1600::SetCadence(word seconds) {
+  m_cadence = seconds;
+}
+
+WS1600::Station *WS1600::FindStation(word id) {
+  unsigned long now = millis();
+  Station *oldest = &m_stations[0];
+  for (byte i = 0; i < WS1600_STATIONS; i++) {
+    Station *station = &m_stations[i];
+    if (station->known != 0 && station->id == id) {
+      return station;
+    }
+    if (station->known == 0 || (oldest->known != 0 && now - station->lastSeen > now - oldest->lastSeen)) {
+      oldest = station;
+    }
+  }
+
+  oldest->id = id;
+  oldest->known = 0;
+  oldest->lastOutput = 0;
+  return oldest;
+}
+
+// Takes the quartets of the frame into the station record and fills the frame
+// with all values of the record that are still current.
+// Returns true if the record is due for output.
+bool WS1600::MergeStation(struct WS1600::Frame *frame) {
+  Station *station = FindStation(frame->ID);
+  unsigned long now = millis();
+  bool first = station->known == 0;
+
+  if (frame->Fresh & (1 << QUARTET_TEMPERATURE)) {
+    station->temperature = frame->Temperature;
+  }
+  if (frame->Fresh & (1 << QUARTET_HUMIDITY)) {
+    station->humidity = frame->Humidity;
+  }
+  if (frame->Fresh & (1 << QUARTET_RAIN)) {
+    station->rain = frame->Rain;
+  }
+  if (frame->Fresh & (1 << QUARTET_WIND)) {
+    station->windSpeed = frame->WindSpeed;
+    station->windDirection = frame->WindDirection;
+  }
+  if (frame->Fresh & (1 << QUARTET_GUST)) {
+    station->windGust = frame->WindGust;
+  }
+  for (byte q = 0; q < QUARTET_COUNT; q++) {
+    if (frame->Fresh & (1 << q)) {
+      station->updated[q] = now;
+    }
+  }
+  station->known |= frame->Fresh;
+  station->lastSeen = now;
+
+  frame->Fresh = 0;
+  for (byte q = 0; q < QUARTET_COUNT; q++) {
+    if ((station->known & (1 << q)) && now - station->updated[q] < WS1600_FIELD_TIMEOUT) {
+      frame->Fresh |= 1 << q;
+    }
+  }
+  frame->Temperature = station->temperature;
+  frame->Humidity = station->humidity;
+  frame->Rain = station->rain;
+  frame->WindSpeed = station->windSpeed;
+  frame->WindDirection = station->windDirection;
+  frame->WindBearing = WH1080::GetWindBearing(station->windDirection);
+  frame->WindGust = station->windGust;
+
+  if (first || m_cadence == 0 || now - station->lastOutput >= m_cadence * 1000UL) {
+    station->lastOutput = now;
+    return true;
+  }
+  return false;
+}
+
 byte WS1600::TryHandleData(byte *data, bool fFhemDisplay) {
-    static struct WS1600::Frame frame;
+    struct WS1600::Frame frame;
+    byte corrected[FRAME_LENGTH];
+    byte dataSets = data[1] & 0x0F;
     DecodeFrame(data, &frame);
+    if (!frame.IsValid && dataSets <= DATASETS_MAX && CorrectFrame(data, corrected, dataSets * 2 + 2 + 1)) {
+      if (IsPlausible(data, corrected) && DecodeFrame(corrected, &frame) > 0 && frame.IsValid) {
+        data = corrected;
+        CountCorrection();
+      }
+      else {
+        frame.IsValid = false;
+      }
+    }
     if (frame.IsValid) {
+      SetLastSensor(PROTOCOL_WS1600, frame.ID);
+      // The complete record of the station at the chosen cadence, the frames in between only update it
+      byte fresh = frame.Fresh;
+      bool due = MergeStation(&frame);
+
+      // The aggregation only takes the quartets in this frame. The delta output gets all current
+      // values of the station, so a snapshot carries every one of them and the unchanged ones
+      // stay within their deadband.
+      if (GetOutputMode() == OUTPUT_DELTA) {
+        fresh = frame.Fresh;
+      }
+      if (fresh & (1 << QUARTET_TEMPERATURE)) {
+        SetValue(VALUE_TEMPERATURE, frame.Temperature);
+      }
+      if (fresh & (1 << QUARTET_HUMIDITY)) {
+        SetValue(VALUE_HUMIDITY, frame.Humidity);
+      }
+      if (fresh & (1 << QUARTET_RAIN)) {
+        SetValue(VALUE_RAIN, frame.Rain);
+      }
+      if (fresh & (1 << QUARTET_WIND)) {
+        SetValue(VALUE_WIND, frame.WindSpeed);
+        SetValue(VALUE_BEARING, frame.WindDirection * 22.5);
+      }
+      if (fresh & (1 << QUARTET_GUST)) {
+        SetValue(VALUE_GUST, frame.WindGust);
+      }
+      if (ForwardValues() || !due) {
+        return frame.frameLength;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
-          return (fhemString.length() > 0) ? frame.frameLength : 0;
+          // A record without temperature or humidity is still a valid frame
+          return frame.frameLength;
   	     }
   	     else {
 		     return DisplayFrame(data, &frame);
@@ -5,19 +5,40 @@
 #include "SensorBase.h"
 #include "WH1080.h"
 
+#ifdef ESP32
+#define WS1600_STATIONS 8
+#else
+#define WS1600_STATIONS 2
+#endif
+#define WS1600_FIELD_TIMEOUT 900000UL               // a merged value older than 15 minutes is dropped
+#define WS1600_RAIN_STEP 50                         // closures a corrected frame may add to the rain counter
+
 class WS1600 : public SensorBase {
 public:
+  static const byte DATASETS_MAX = 5;
+
+  enum Quartet {
+    QUARTET_TEMPERATURE = 0,
+    QUARTET_HUMIDITY,
+    QUARTET_RAIN,
+    QUARTET_WIND,
+    QUARTET_GUST,
+    QUARTET_COUNT
+  };
+
   struct Frame {
     byte  Header;
-    byte  ID;
+    word  ID;                     // 10 bits
     byte  DataSets;
-    char  *SensorType[5];
+    const char *SensorType[DATASETS_MAX];
     double Temperature;
     byte  Humidity;
     double WindSpeed;
     double WindGust;
     double Rain;
-    char *WindBearing;
+    const char *WindBearing;
+    byte  WindDirection;
+    byte  Fresh;                  // bit per Quartet with a current value
     byte  CRC;
     bool  IsValid;
     byte frameLength;
@@ -25,11 +46,36 @@ public:
 
   static const byte FRAME_LENGTH = 13;
   static byte CalculateCRC(byte data[], byte frameLength=FRAME_LENGTH);
+  static bool IsPlausible(byte *data, byte *corrected);
   static byte DecodeFrame(byte *bytes, struct WS1600::Frame *frame);
   static byte DisplayFrame(byte *data, struct WS1600::Frame *frame, bool fOnlyIfValid = true);
   static void AnalyzeFrame(byte *data, bool fOnlyIfValid = false);
   static byte TryHandleData(byte *data, bool fFhemDisplay = true);
   static String GetFhemDataString(struct WS1600::Frame *frame);
+  static void SetCadence(word seconds);
+
+private:
+  // After the acquisition phase a frame carries only some quartets, a station
+  // record collects them so the output has all values that are still current
+  struct Station {
+    word id;
+    byte known;                   // bit per Quartet received so far
+    float temperature;
+    byte humidity;
+    float rain;
+    float windSpeed;
+    byte windDirection;
+    float windGust;
+    unsigned long updated[QUARTET_COUNT];
+    unsigned long lastSeen;
+    unsigned long lastOutput;
+  };
+
+  static Station m_stations[WS1600_STATIONS];
+  static word m_cadence;
+
+  static Station *FindStation(word id);
+  static bool MergeStation(struct WS1600::Frame *frame);
 
 };
 
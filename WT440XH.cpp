@@ -44,11 +44,20 @@ bool WT440XH::TryHandleData(byte *data, bool fFhemDisplay) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
+      SetLastSensor(PROTOCOL_WT440XH, frame.ID);
+      SetValue(VALUE_TEMPERATURE, frame.Temperature);
+      SetValue(VALUE_HUMIDITY, frame.Humidity);
+      SetValue(VALUE_BATTERY, frame.WeakBatteryFlag);
+      if (ForwardValues()) {
+        return true;
+      }
 	  if (fFhemDisplay) {
           String fhemString = "";
           fhemString = GetFhemDataString(&frame);
           if (fhemString.length() > 0) {
-            Serial.println(fhemString);
+            Serial.print(fhemString);
+            DisplayOptionalFields();
+            Serial.println();
           }
           return fhemString.length() > 0;
   	     }
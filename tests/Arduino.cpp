@@ -0,0 +1,39 @@
+#include "Arduino.h"
+#include "EEPROM.h"
+#include <sys/time.h>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+static bool simulated = false;
+static unsigned long simulatedMicros = 0;
+
+void SetMicros(unsigned long us) {
+  simulated = true;
+  simulatedMicros = us;
+}
+
+unsigned long micros() {
+  if (simulated) {
+    return simulatedMicros;
+  }
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec * 1000000UL + now.tv_usec;
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+String::String(long value, int base) {
+  char buffer[24];
+  snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%ld", value);
+  assign(buffer);
+}
+
+String::String(double value, int decimals) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+  assign(buffer);
+}
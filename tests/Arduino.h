@@ -0,0 +1,68 @@
+#ifndef _ARDUINO_HOST_h
+#define _ARDUINO_HOST_h
+
+// Just enough of the Arduino core to run the decoders on the host
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+unsigned long millis();
+unsigned long micros();
+// Tests of timing logic run on a simulated clock once it was set
+void SetMicros(unsigned long us);
+
+class String : public std::string {
+public:
+  String() {}
+  String(const char *s) : std::string(s) {}
+  String(long value, int base = DEC);
+  String(double value, int decimals = 2);
+  String &operator+=(const char *s) { append(s); return *this; }
+  String &operator+=(const String &s) { append(s); return *this; }
+  String &operator+=(char c) { push_back(c); return *this; }
+  String &operator+=(byte value) { return *this += String((long)value); }
+  String &operator+=(int value) { return *this += String((long)value); }
+  String &operator+=(unsigned int value) { return *this += String((long)value); }
+  String &operator+=(long value) { return *this += String(value); }
+  String &operator+=(unsigned long value) { return *this += String((long)value); }
+  String &operator+=(double value) { return *this += String(value); }
+};
+
+class HardwareSerial {
+public:
+  size_t print(const char *s) { return printf("%s", s); }
+  size_t print(const __FlashStringHelper *s) { return print((const char *)s); }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(char c) { return printf("%c", c); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC) { return base == HEX ? printf("%lX", value) : printf("%ld", value); }
+  size_t print(unsigned long value, int base = DEC) { return base == HEX ? printf("%lX", value) : printf("%lu", value); }
+  size_t print(double value, int decimals = 2) { return printf("%.*f", decimals, value); }
+  size_t println() { return printf("\n"); }
+  int available() { return 0; }
+  void flush() { fflush(stdout); }
+  template<typename T> size_t println(T value) { return print(value) + println(); }
+  template<typename T> size_t println(T value, int format) { return print(value, format) + println(); }
+};
+extern HardwareSerial Serial;
+
+#endif
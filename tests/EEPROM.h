@@ -0,0 +1,19 @@
+#ifndef _EEPROM_HOST_h
+#define _EEPROM_HOST_h
+
+#include "Arduino.h"
+
+// An erased EEPROM in RAM
+class EEPROMClass {
+public:
+  EEPROMClass() { memset(m_cells, 0xFF, sizeof(m_cells)); }
+  byte read(int address) { return m_cells[address]; }
+  void write(int address, byte value) { m_cells[address] = value; }
+  template<typename T> T &get(int address, T &value) { memcpy(&value, m_cells + address, sizeof(T)); return value; }
+  template<typename T> const T &put(int address, const T &value) { memcpy(m_cells + address, &value, sizeof(T)); return value; }
+private:
+  byte m_cells[1024];
+};
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef _RFMXX_h
+#define _RFMXX_h
+
+#include "Arduino.h"
+
+// Stands in for RFMxx.h in the tests of the power save, it tracks when the receiver is off
+class RFMxx {
+private:
+  bool m_powered;
+  unsigned long m_offSince;
+  unsigned long m_offMillis;
+
+public:
+  RFMxx() : m_powered(true), m_offSince(0), m_offMillis(0) {}
+  void PowerDown() {
+    if (m_powered) {
+      m_powered = false;
+      m_offSince = millis();
+    }
+  }
+  void EnableReceiver(bool enable, bool fClearFifo = true) {
+    if (enable && !m_powered) {
+      m_powered = true;
+      m_offMillis += millis() - m_offSince;
+    }
+  }
+  bool IsListening() { return false; }
+  unsigned long GetOffMillis() { return m_offMillis; }
+};
+
+#endif
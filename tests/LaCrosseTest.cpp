@@ -0,0 +1,60 @@
+#include "LaCrosse.h"
+
+// Decoding of LaCrosse frames and the single bit correction
+
+static int failures = 0;
+
+static void Check(bool condition, const char *name) {
+  printf("%s %s\n", condition ? "PASS" : "FAIL", name);
+  if (!condition) {
+    failures++;
+  }
+}
+
+static void EncodeReading(byte *bytes) {
+  LaCrosse::Frame frame;
+  frame.ID = 56;
+  frame.NewBatteryFlag = false;
+  frame.Bit12 = false;
+  frame.Temperature = 21.6;
+  frame.WeakBatteryFlag = false;
+  frame.Humidity = 56;
+  LaCrosse::EncodeFrame(&frame, bytes);
+}
+
+int main() {
+  SensorBase::EnableCorrection(true);
+  byte bytes[LaCrosse::FRAME_LENGTH];
+
+  EncodeReading(bytes);
+  Check(LaCrosse::TryHandleData(bytes), "valid frame decodes");
+  Check(SensorBase::GetLastID() == 56, "ID of the valid frame");
+
+  unsigned long corrections = SensorBase::GetCorrections();
+  EncodeReading(bytes);
+  bytes[2] ^= 0x20;
+  Check(LaCrosse::TryHandleData(bytes), "single bit error decodes");
+  Check(SensorBase::GetCorrections() == corrections + 1, "single bit error is counted");
+
+  // A flipped bit of the ID is taken back as well, not read as another sensor
+  EncodeReading(bytes);
+  bytes[1] ^= 0x40;
+  Check(LaCrosse::TryHandleData(bytes) && SensorBase::GetLastID() == 56, "flipped ID bit is corrected");
+
+  // A temperature digit of 0xA is no BCD, the flipped CRC bit would be corrected
+  corrections = SensorBase::GetCorrections();
+  EncodeReading(bytes);
+  bytes[2] = (bytes[2] & 0xF0) | 0x0A;
+  bytes[4] = LaCrosse::CalculateCRC(bytes) ^ 0x01;
+  Check(!LaCrosse::TryHandleData(bytes), "frame without BCD digits does not decode");
+
+  // A humidity of 110 % is no value a sensor sends
+  EncodeReading(bytes);
+  bytes[3] = 110;
+  bytes[4] = LaCrosse::CalculateCRC(bytes) ^ 0x80;
+  Check(!LaCrosse::TryHandleData(bytes), "frame with implausible humidity does not decode");
+  Check(SensorBase::GetCorrections() == corrections, "no correction is counted");
+
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
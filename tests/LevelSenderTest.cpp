@@ -0,0 +1,52 @@
+#include "LevelSenderLib.h"
+
+// Decoding of LevelSender frames and the single bit correction
+
+static int failures = 0;
+
+static void Check(bool condition, const char *name) {
+  printf("%s %s\n", condition ? "PASS" : "FAIL", name);
+  if (!condition) {
+    failures++;
+  }
+}
+
+static void EncodeReading(byte *bytes) {
+  LevelSenderLib::Frame frame;
+  frame.Header = 11;
+  frame.ID = 3;
+  frame.Level = 121.5;
+  frame.Temperature = 21.5;
+  frame.Voltage = 5.7;
+  LevelSenderLib::EncodeFrame(&frame, bytes);
+}
+
+int main() {
+  SensorBase::EnableCorrection(true);
+  byte bytes[LevelSenderLib::FRAME_LENGTH];
+
+  EncodeReading(bytes);
+  Check(LevelSenderLib::TryHandleData(bytes), "valid frame decodes");
+
+  unsigned long corrections = SensorBase::GetCorrections();
+  EncodeReading(bytes);
+  bytes[3] ^= 0x10;
+  Check(LevelSenderLib::TryHandleData(bytes), "single bit error decodes");
+  Check(SensorBase::GetCorrections() == corrections + 1, "single bit error is counted");
+
+  // A temperature digit of 0xA is within range but no BCD, the flipped CRC bit would be corrected
+  corrections = SensorBase::GetCorrections();
+  EncodeReading(bytes);
+  bytes[3] = (bytes[3] & 0xF0) | 0x0A;
+  bytes[5] = LevelSenderLib::CalculateCRC(bytes) ^ 0x01;
+  Check(!LevelSenderLib::TryHandleData(bytes), "frame without BCD digits does not decode");
+
+  // WH1080 time frame of 09:00:45 2026-10-19 with a valid CRC. Flipping bit 3 of the first
+  // byte would give ID 12, 115.0 cm, 50.0 C and 4.5 V, all BCD and within range.
+  byte time[] = { 0xB4, 0x23, 0x09, 0x00, 0x45, 0x26, 0x10, 0x19, 0x00, 0x54 };
+  Check(!LevelSenderLib::TryHandleData(time), "WH1080 time frame does not decode");
+  Check(SensorBase::GetCorrections() == corrections, "no correction is counted");
+
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
@@ -0,0 +1,113 @@
+#include "FakeRFMxx.h"
+#include "PowerSave.h"
+#include "SensorBase.h"
+
+// The power save on a simulated clock: periodic sensors with dropped and late frames,
+// the radio only receives what comes while it is not powered down
+
+#define SIMULATED_MILLIS  400000UL          // 100 frames of a TX29-IT
+#define PERIOD_MILLIS     4000UL
+#define NO_FRAME          0xFFFF
+
+struct Sensor {
+  word id;
+  unsigned long first;                      // millis() of frame 0
+  word frame;                               // the next frame
+  word drop[2];                             // frames that are not sent
+  word late;                                // frame sent lateMillis after its slot
+  unsigned long lateMillis;
+};
+
+struct Result {
+  unsigned long captured;
+  unsigned long missed;
+  unsigned long received;
+  float duty;
+};
+
+static int failures = 0;
+
+static void Check(bool condition, const char *name) {
+  printf("%s %s\n", condition ? "PASS" : "FAIL", name);
+  if (!condition) {
+    failures++;
+  }
+}
+
+static unsigned long FrameMillis(Sensor *sensor) {
+  unsigned long at = sensor->first + sensor->frame * PERIOD_MILLIS;
+  return sensor->frame == sensor->late ? at + sensor->lateMillis : at;
+}
+
+static bool IsSent(Sensor *sensor) {
+  return sensor->frame != sensor->drop[0] && sensor->frame != sensor->drop[1];
+}
+
+static Result Simulate(Sensor *sensors, byte sensorCount) {
+  RFMxx radio;
+  RFMxx *radios[] = { &radio };
+  PowerSave powerSave(radios, 1);
+  Result result = { 0, 0, 0, 0 };
+
+  SetMicros(0);
+  powerSave.Enable(true);
+  while (millis() < SIMULATED_MILLIS) {
+    for (byte s = 0; s < sensorCount; s++) {
+      Sensor *sensor = &sensors[s];
+      while (FrameMillis(sensor) <= millis()) {
+        if (IsSent(sensor)) {
+          powerSave.Update(SensorBase::PROTOCOL_LACROSSE, sensor->id);
+          result.received++;
+        }
+        sensor->frame++;
+      }
+    }
+
+    // The frames sent while the radio was powered down are lost
+    powerSave.Handle();
+    for (byte s = 0; s < sensorCount; s++) {
+      while (FrameMillis(&sensors[s]) < millis()) {
+        sensors[s].frame++;
+      }
+    }
+    SetMicros((millis() + 1) * 1000);
+  }
+
+  result.captured = powerSave.GetCaptured();
+  result.missed = powerSave.GetMissed();
+  result.duty = 100.0 - radio.GetOffMillis() * 100.0 / millis();
+  return result;
+}
+
+static void Print(const char *name, Result &result) {
+  printf("%s: received %lu captured %lu missed %lu duty %.1f%%\n", name,
+    result.received, result.captured, result.missed, result.duty);
+}
+
+int main() {
+  Sensor onTime[] = { { 10, 1000, 0, { NO_FRAME, NO_FRAME }, NO_FRAME, 0 } };
+  Result regular = Simulate(onTime, 1);
+  Print("on time", regular);
+  Check(regular.missed == 0, "frames on time are not missed");
+  Check(regular.captured > 90 && regular.captured == regular.received - 5, "every frame after the lock is captured");
+  Check(regular.duty < 10, "the radio sleeps between the frames");
+
+  Sensor dropped[] = { { 10, 1000, 0, { 20, 50 }, NO_FRAME, 0 } };
+  Result lost = Simulate(dropped, 1);
+  Print("dropped", lost);
+  Check(lost.missed == 2, "dropped frames are missed");
+  Check(lost.captured + lost.missed == regular.captured, "every predicted slot counts once");
+
+  // The late frame comes after the guard, the window of the second sensor keeps the radio on
+  Sensor late[] = {
+    { 10, 1000, 0, { NO_FRAME, NO_FRAME }, 30, 120 },
+    { 20, 1150, 0, { NO_FRAME, NO_FRAME }, NO_FRAME, 0 }
+  };
+  Result delayed = Simulate(late, 2);
+  Print("late", delayed);
+  Check(delayed.missed == 0, "a late frame received is not missed");
+  Check(delayed.captured == delayed.received - 10, "the late frame does not move the prediction");
+
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
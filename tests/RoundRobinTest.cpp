@@ -0,0 +1,162 @@
+#include "Arduino.h"
+
+// Host simulation of the reception loop of LaCrosseITPlusReader.ino: two radios, each pinned
+// to a data rate and polled round robin, against one radio toggling between the data rates.
+// A radio with a payload waiting is blind until the loop took it, as in the fixed length mode.
+
+#define SIMULATED_MICROS  3600000000ULL     // one hour
+#define POLL_MICROS       60                // SPI poll of an idle radio
+#define HANDLE_MICROS     8000              // decoding and about 45 characters at 57600 baud
+#define LOOP_MICROS       150               // serial input, AFC, clock and the other handlers
+#define TOGGLE_MICROS     30000000ULL       // TOGGLE_DATA_RATE of 30 seconds
+#define RADIOS_MAX        2
+
+struct Sensor {
+  unsigned long rate;
+  unsigned long period;                     // ms
+  byte length;                              // bytes on air with preamble and sync word
+  uint64_t next;                            // start of the next frame
+  unsigned long sent;
+  unsigned long received;
+};
+
+struct Radio {
+  unsigned long rate;
+  bool ready;
+  uint64_t readyAt;
+};
+
+struct Result {
+  float capture[2];                         // fast and slow sensors
+  uint64_t maxWait;                         // from a payload ready to the loop taking it
+  uint64_t meanWait;
+};
+
+static int failures = 0;
+static unsigned long seed = 1;
+
+static void Check(bool condition, const char *name) {
+  printf("%s %s\n", condition ? "PASS" : "FAIL", name);
+  if (!condition) {
+    failures++;
+  }
+}
+
+// Transmit intervals jitter by a few percent between sensors and frames
+static unsigned long Jitter(unsigned long ms) {
+  seed = seed * 1103515245UL + 12345UL;
+  return ms - ms / 32 + (seed >> 8) % (ms / 16);
+}
+
+static byte SetupSensors(Sensor *sensors) {
+  byte count = 0;
+  // TX29-IT at 17241 bps about every 4 seconds, TX22-IT at 8621 bps about every 13 seconds
+  for (byte i = 0; i < 6; i++) {
+    sensors[count++] = { 17241, 4000, 5 + 5, 0, 0, 0 };
+  }
+  for (byte i = 0; i < 3; i++) {
+    sensors[count++] = { 8621, 13000, 9 + 5, 0, 0, 0 };
+  }
+  seed = 1;
+  for (byte i = 0; i < count; i++) {
+    sensors[i].next = Jitter(sensors[i].period) * 1000ULL;
+  }
+  return count;
+}
+
+// Delivers the frames that ended until now to the radios at their data rate
+static void Advance(Sensor *sensors, byte sensorCount, Radio *radios, byte radioCount, uint64_t now) {
+  for (byte s = 0; s < sensorCount; s++) {
+    Sensor *sensor = &sensors[s];
+    uint64_t airtime = sensor->length * 8 * 1000000ULL / sensor->rate;
+    while (sensor->next + airtime <= now) {
+      sensor->sent++;
+      for (byte r = 0; r < radioCount; r++) {
+        if (radios[r].rate == sensor->rate && !radios[r].ready) {
+          radios[r].ready = true;
+          radios[r].readyAt = sensor->next + airtime;
+          sensor->received++;
+          break;
+        }
+      }
+      sensor->next += Jitter(sensor->period) * 1000ULL;
+    }
+  }
+}
+
+static Result Simulate(byte radioCount, bool toggle) {
+  Sensor sensors[16];
+  byte sensorCount = SetupSensors(sensors);
+  Radio radios[RADIOS_MAX] = { { 17241, false, 0 }, { 8621, false, 0 } };
+  uint64_t now = 0;
+  uint64_t lastToggle = 0;
+  uint64_t waitSum = 0;
+  unsigned long waits = 0;
+  Result result = { { 0, 0 }, 0, 0 };
+  byte firstRadio = 0;
+
+  while (now < SIMULATED_MICROS) {
+    now += LOOP_MICROS;
+    Advance(sensors, sensorCount, radios, radioCount, now);
+    if (toggle && now - lastToggle >= TOGGLE_MICROS) {
+      radios[0].rate = radios[0].rate == 17241 ? 8621 : 17241;
+      radios[0].ready = false;
+      lastToggle = now;
+    }
+
+    // The poll loop of the sketch, starting with another radio each time
+    for (byte n = 0; n < radioCount; n++) {
+      byte r = (firstRadio + n) % radioCount;
+      now += POLL_MICROS;
+      Advance(sensors, sensorCount, radios, radioCount, now);
+      if (radios[r].ready) {
+        uint64_t wait = now - radios[r].readyAt;
+        waitSum += wait;
+        waits++;
+        if (wait > result.maxWait) {
+          result.maxWait = wait;
+        }
+        now += HANDLE_MICROS;
+        Advance(sensors, sensorCount, radios, radioCount, now);
+        radios[r].ready = false;
+      }
+    }
+    firstRadio = (firstRadio + 1) % radioCount;
+  }
+
+  unsigned long sent[2] = { 0, 0 };
+  unsigned long received[2] = { 0, 0 };
+  for (byte s = 0; s < sensorCount; s++) {
+    byte slow = sensors[s].rate != 17241;
+    sent[slow] += sensors[s].sent;
+    received[slow] += sensors[s].received;
+  }
+  for (byte i = 0; i < 2; i++) {
+    result.capture[i] = sent[i] ? received[i] * 100.0 / sent[i] : 0;
+  }
+  result.meanWait = waits ? waitSum / waits : 0;
+  return result;
+}
+
+static void Print(const char *name, Result &result) {
+  printf("%s: 17241 %.1f%% 8621 %.1f%% wait %lu us max %lu us\n", name,
+    result.capture[0], result.capture[1],
+    (unsigned long)result.meanWait, (unsigned long)result.maxWait);
+}
+
+int main() {
+  Result pinned = Simulate(2, false);
+  Result toggled = Simulate(1, true);
+  Print("pinned", pinned);
+  Print("toggled", toggled);
+
+  Check(pinned.capture[0] >= 95 && pinned.capture[1] >= 95, "pinned radios capture both data rates");
+  Check(toggled.capture[0] <= 60 && toggled.capture[1] <= 60, "a toggling radio misses about half");
+  // A payload waits for at most one frame of the other radio, the rotation lets none starve
+  Check(pinned.maxWait <= HANDLE_MICROS + LOOP_MICROS + 2 * POLL_MICROS, "round robin wait is one frame at most");
+  // The arbitration overhead, the poll of the other radio delays a payload on average
+  Check(pinned.meanWait <= toggled.meanWait + 2 * POLL_MICROS, "second radio adds at most two polls of wait");
+
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
@@ -0,0 +1,73 @@
+#include "WS1600.h"
+
+// Decoding of WS1600 frames, the single bit correction and the checks of a corrected frame
+
+#define STATION_ID 705
+
+static int failures = 0;
+
+static void Check(bool condition, const char *name) {
+  printf("%s %s\n", condition ? "PASS" : "FAIL", name);
+  if (!condition) {
+    failures++;
+  }
+}
+
+// Header 0xA, the station ID, the quartet count, two bytes per quartet and the CRC
+static void EncodeReading(byte *bytes, const byte *quartets, byte dataSets) {
+  bytes[0] = 0xA0 | (STATION_ID >> 6);
+  bytes[1] = ((STATION_ID & 0x03) << 6) | dataSets;
+  memcpy(&bytes[2], quartets, dataSets * 2);
+  bytes[dataSets * 2 + 2] = WS1600::CalculateCRC(bytes, dataSets * 2 + 3);
+}
+
+int main() {
+  SensorBase::EnableCorrection(true);
+  byte bytes[WS1600::FRAME_LENGTH];
+
+  // 22.8 C, 33 %, rain counter 505, wind 2 m/s from NW, gust 3 m/s
+  const byte all[] = { 0x06, 0x28, 0x10, 0x33, 0x25, 0x05, 0x3E, 0x02, 0x40, 0x03 };
+  EncodeReading(bytes, all, 5);
+  Check(WS1600::TryHandleData(bytes) > 0, "valid frame decodes");
+  Check(SensorBase::GetLastID() == STATION_ID, "ID of the valid frame");
+
+  unsigned long corrections = SensorBase::GetCorrections();
+  EncodeReading(bytes, all, 5);
+  bytes[3] ^= 0x04;
+  Check(WS1600::TryHandleData(bytes) > 0, "single bit error decodes");
+  Check(SensorBase::GetCorrections() == corrections + 1, "single bit error is counted");
+
+  // A frame with only the rain quartet, a flipped bit of the counter is taken back
+  const byte rain[] = { 0x28, 0x05 };
+  EncodeReading(bytes, rain, 1);
+  bytes[3] ^= 0x80;
+  Check(WS1600::TryHandleData(bytes) > 0, "flipped rain bit is corrected");
+  Check(SensorBase::GetCorrections() == corrections + 2, "rain correction is counted");
+
+  // An unknown sensor type, the flipped CRC bit would be corrected
+  corrections = SensorBase::GetCorrections();
+  const byte unknown[] = { 0x06, 0x28, 0x50, 0x33 };
+  EncodeReading(bytes, unknown, 2);
+  bytes[6] ^= 0x01;
+  Check(WS1600::TryHandleData(bytes) == 0, "frame with unknown sensor type does not decode");
+
+  // A rain counter 95 closures above the last one of the station, and a counter running back
+  const byte jump[] = { 0x23, 0x06 };
+  EncodeReading(bytes, jump, 1);
+  bytes[4] ^= 0x10;
+  Check(WS1600::TryHandleData(bytes) == 0, "rain counter jump does not decode");
+  const byte back[] = { 0x20, 0x05 };
+  EncodeReading(bytes, back, 1);
+  bytes[4] ^= 0x02;
+  Check(WS1600::TryHandleData(bytes) == 0, "rain counter running back does not decode");
+
+  // A units digit of 0xA is not taken
+  const byte digit[] = { 0x2A, 0x05 };
+  EncodeReading(bytes, digit, 1);
+  bytes[4] ^= 0x40;
+  Check(WS1600::TryHandleData(bytes) == 0, "rain without a units digit does not decode");
+  Check(SensorBase::GetCorrections() == corrections, "no correction is counted");
+
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
@@ -0,0 +1,12 @@
+#ifndef _AVR_SLEEP_HOST_h
+#define _AVR_SLEEP_HOST_h
+
+#include "Arduino.h"
+
+// The idle sleep of the ATmega328 on the simulated clock, woken by the tick of timer 0
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(byte mode) {}
+inline void sleep_mode() { SetMicros(micros() + 1000); }
+
+#endif